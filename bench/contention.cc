@@ -0,0 +1,246 @@
+/**
+ * Lock contention benchmark for `pollcoro::mutex` and `pollcoro::shared_mutex`.
+ *
+ * Each case starts 1 to 64 OS threads, each driving `--tasks` (default 8)
+ * tasks with `block_on(wait_all(...))`. Every task repeatedly acquires the
+ * lock, holds it for a fixed critical section of busy work and releases it,
+ * until the run time is up. For `shared_mutex`, each acquisition is a read
+ * with the given probability and a write otherwise.
+ *
+ * Reported per case:
+ * - `ops_per_sec`: acquisitions per second across all threads
+ * - `fairness`: maximum over mean time from requesting the lock to acquiring it
+ * - `task_ops_min_max`: fewest over most acquisitions made by a single task
+ * - `contended`: fraction of acquisitions that had to wait
+ * - `wait_*`: request-to-acquire latency percentiles
+ * - `wake_*`: wake-to-acquire latency, from the unlock that released the lock
+ *   to the waiting task's acquisition, for acquisitions that had to wait
+ *
+ * With `--json`, the power-of-two buckets of both histograms are included.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <latch>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "harness.h"
+
+import pollcoro;
+
+namespace bench = pollcoro_bench;
+
+// =============================================================================
+// Helpers
+// =============================================================================
+
+std::int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               bench::clock::now().time_since_epoch()
+    )
+        .count();
+}
+
+void busy_work(std::chrono::nanoseconds duration) {
+    if (duration.count() == 0) {
+        return;
+    }
+    auto until = bench::clock::now() + duration;
+    while (bench::clock::now() < until) {
+    }
+}
+
+// Forwards to a lock awaitable, recording whether it ever returned pending
+template<typename Awaitable>
+class observe_wait : public pollcoro::awaitable_always_blocks {
+    Awaitable awaitable_;
+    bool& waited_;
+
+  public:
+    observe_wait(Awaitable&& awaitable, bool& waited)
+        : awaitable_(std::move(awaitable)), waited_(waited) {}
+
+    auto poll(const pollcoro::waker& w) {
+        auto state = awaitable_.poll(w);
+        if (!state.is_ready()) {
+            waited_ = true;
+        }
+        return state;
+    }
+};
+
+struct task_stats {
+    std::uint64_t ops = 0;
+    std::uint64_t contended = 0;
+    double wait_sum = 0;
+    std::uint64_t wait_max = 0;
+    bench::log2_histogram waits;
+    bench::log2_histogram wakes;
+};
+
+struct shared_state {
+    std::atomic<bool> stop{false};
+    alignas(64) std::atomic<std::int64_t> last_release{0};
+};
+
+struct config {
+    unsigned threads;
+    unsigned tasks;
+    std::chrono::nanoseconds critical_section;
+    // Probability of a shared acquisition; ignored for `mutex`
+    double read_ratio;
+};
+
+template<typename Lock>
+pollcoro::task<> worker(
+    Lock& lock, shared_state& shared, const config& cfg, task_stats& stats, std::uint64_t seed
+) {
+    auto rng = seed * 0x9e3779b97f4a7c15ull + 1;
+
+    while (!shared.stop.load(std::memory_order_relaxed)) {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+
+        bool waited = false;
+        auto requested = now_ns();
+        auto on_acquired = [&] {
+            auto acquired = now_ns();
+            auto wait = static_cast<std::uint64_t>(acquired - requested);
+            ++stats.ops;
+            stats.wait_sum += static_cast<double>(wait);
+            stats.wait_max = std::max(stats.wait_max, wait);
+            stats.waits.record(wait);
+            if (waited) {
+                ++stats.contended;
+                auto released = shared.last_release.load(std::memory_order_relaxed);
+                stats.wakes.record(static_cast<std::uint64_t>(std::max<std::int64_t>(
+                    acquired - std::max(released, requested), 0
+                )));
+            }
+            busy_work(cfg.critical_section);
+            shared.last_release.store(now_ns(), std::memory_order_relaxed);
+        };
+
+        if constexpr (std::is_same_v<Lock, pollcoro::mutex>) {
+            auto guard = co_await observe_wait(lock.lock(), waited);
+            on_acquired();
+        } else {
+            if (static_cast<double>(rng >> 11) * 0x1.0p-53 < cfg.read_ratio) {
+                auto guard = co_await observe_wait(lock.lock_shared(), waited);
+                on_acquired();
+            } else {
+                auto guard = co_await observe_wait(lock.lock(), waited);
+                on_acquired();
+            }
+        }
+    }
+}
+
+template<typename Lock>
+void run_case(bench::runner& r, const std::string& name, const config& cfg) {
+    if (!r.enabled(name)) {
+        return;
+    }
+
+    Lock lock;
+    shared_state shared;
+    std::vector<task_stats> stats(std::size_t(cfg.threads) * cfg.tasks);
+    std::latch ready(cfg.threads + 1);
+    std::vector<std::thread> threads;
+
+    for (unsigned t = 0; t < cfg.threads; ++t) {
+        threads.emplace_back([&, t] {
+            std::vector<pollcoro::task<>> tasks;
+            for (unsigned i = 0; i < cfg.tasks; ++i) {
+                auto index = std::size_t(t) * cfg.tasks + i;
+                tasks.push_back(worker(lock, shared, cfg, stats[index], index));
+            }
+            ready.arrive_and_wait();
+            pollcoro::block_on(pollcoro::wait_all(tasks));
+        });
+    }
+
+    ready.arrive_and_wait();
+    auto start = bench::clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(r.min_time()));
+    shared.stop.store(true, std::memory_order_relaxed);
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto elapsed = bench::elapsed_ns(start, bench::clock::now());
+
+    task_stats total;
+    std::uint64_t task_min = UINT64_MAX;
+    std::uint64_t task_max = 0;
+    for (auto& s : stats) {
+        total.ops += s.ops;
+        total.contended += s.contended;
+        total.wait_sum += s.wait_sum;
+        total.wait_max = std::max(total.wait_max, s.wait_max);
+        total.waits.merge(s.waits);
+        total.wakes.merge(s.wakes);
+        task_min = std::min(task_min, s.ops);
+        task_max = std::max(task_max, s.ops);
+    }
+    if (total.ops == 0) {
+        return;
+    }
+
+    auto ops = static_cast<double>(total.ops);
+    auto wait_mean = total.wait_sum / ops;
+    bench::result result{name, total.ops, elapsed / ops};
+    result.add("ops_per_sec", ops * 1e9 / elapsed)
+        .add("fairness", wait_mean > 0 ? static_cast<double>(total.wait_max) / wait_mean : 1)
+        .add("task_ops_min_max", static_cast<double>(task_min) / static_cast<double>(task_max))
+        .add("contended", static_cast<double>(total.contended) / ops)
+        .add("wait_mean_ns", wait_mean);
+    total.waits.summarize(result, "wait");
+    total.wakes.summarize(result, "wake");
+    if (r.json()) {
+        total.waits.buckets(result, "wait");
+        total.wakes.buckets(result, "wake");
+    }
+    r.report(result);
+}
+
+std::string suffix(const config& cfg) {
+    return "/threads:" + std::to_string(cfg.threads) +
+        "/cs:" + std::to_string(cfg.critical_section.count()) + "ns";
+}
+
+int main(int argc, char** argv) {
+    bench::runner r(argc, argv, {"tasks", "max-threads"});
+    auto tasks = static_cast<unsigned>(r.option("tasks", 8));
+    auto max_threads = static_cast<unsigned>(r.option("max-threads", 64));
+
+    using std::chrono::nanoseconds;
+    const nanoseconds critical_sections[] = {nanoseconds(0), nanoseconds(100), nanoseconds(1000)};
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        for (auto cs : critical_sections) {
+            config cfg{threads, tasks, cs, 0};
+            run_case<pollcoro::mutex>(r, "contention/mutex" + suffix(cfg), cfg);
+        }
+    }
+
+    for (int read_percent : {0, 50, 90, 99}) {
+        for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+            for (auto cs : critical_sections) {
+                config cfg{threads, tasks, cs, read_percent / 100.0};
+                run_case<pollcoro::shared_mutex>(
+                    r,
+                    "contention/shared_mutex/read:" + std::to_string(read_percent) + "%" +
+                        suffix(cfg),
+                    cfg
+                );
+            }
+        }
+    }
+}
@@ -0,0 +1,291 @@
+/**
+ * Microbenchmarks for the core poll/wake paths.
+ *
+ * Covers task frame allocation, polling through nested co_await chains,
+ * block_on wake handling, cross-thread single_event latency, mutex
+ * throughput, wait_all fan-out and a small stream pipeline. Run with `--json`
+ * for machine-readable output.
+ */
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "harness.h"
+
+import pollcoro;
+
+namespace bench = pollcoro_bench;
+
+// =============================================================================
+// Helpers
+// =============================================================================
+
+// Completes after `n` polls, waking itself in between
+class countdown : public pollcoro::awaitable_always_blocks {
+    std::uint64_t remaining_;
+
+  public:
+    explicit countdown(std::uint64_t n) : remaining_(n) {}
+
+    pollcoro::awaitable_state<> poll(const pollcoro::waker& w) {
+        if (remaining_ == 0) {
+            return pollcoro::awaitable_state<>::ready();
+        }
+        --remaining_;
+        w.wake();
+        return pollcoro::awaitable_state<>::pending();
+    }
+};
+
+template<typename Awaitable>
+auto poll_to_completion(Awaitable& awaitable) {
+    while (true) {
+        auto state = awaitable.poll(pollcoro::waker());
+        if (state.is_ready()) {
+            return state;
+        }
+    }
+}
+
+pollcoro::task<int> immediate(int value) {
+    co_return value;
+}
+
+pollcoro::task<> chain(int depth, std::uint64_t polls) {
+    if (depth <= 1) {
+        co_await countdown(polls);
+    } else {
+        co_await chain(depth - 1, polls);
+    }
+}
+
+// =============================================================================
+// Cases
+// =============================================================================
+
+void bench_task(bench::runner& r) {
+    r.run("task/create_destroy", [](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i) {
+            auto t = immediate(static_cast<int>(i));
+            bench::do_not_optimize(t);
+        }
+    });
+
+    r.run("task/create_poll_destroy", [](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i) {
+            auto t = immediate(static_cast<int>(i));
+            bench::do_not_optimize(poll_to_completion(t).take_result());
+        }
+    });
+}
+
+void bench_await_chain(bench::runner& r) {
+    // Cost of one poll of the root task while the leaf is pending
+    for (int depth : {1, 8, 64}) {
+        r.run("await_chain/poll/depth:" + std::to_string(depth), [&](std::uint64_t n) {
+            auto t = chain(depth, n);
+            poll_to_completion(t);
+        });
+    }
+
+    // Building and completing the whole chain, per level
+    for (int depth : {1, 8, 64}) {
+        auto name = "await_chain/build_complete/depth:" + std::to_string(depth);
+        if (!r.enabled(name)) {
+            continue;
+        }
+        auto result = r.measure(name, [&](std::uint64_t n) {
+            for (std::uint64_t i = 0; i < n; ++i) {
+                auto t = chain(depth, 0);
+                poll_to_completion(t);
+            }
+        });
+        result.add("ns_per_level", result.ns_per_op / depth);
+        r.report(result);
+    }
+}
+
+void bench_block_on(bench::runner& r) {
+    // Awaitable wakes itself synchronously; measures block_on's notify/wait
+    // round trip without a thread hop
+    r.run("block_on/self_wake", [](std::uint64_t n) {
+        pollcoro::block_on(countdown(n));
+    });
+
+    r.run("block_on/ready", [](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i) {
+            bench::do_not_optimize(pollcoro::block_on(immediate(1)));
+        }
+    });
+}
+
+void bench_single_event(bench::runner& r) {
+    const std::string name = "single_event/cross_thread_set_to_resume";
+    if (!r.enabled(name)) {
+        return;
+    }
+
+    constexpr int rounds = 20000;
+    bench::histogram latencies;
+    latencies.reserve(rounds);
+
+    std::atomic<std::int64_t> set_at{0};
+    std::atomic<int> round{-1};
+    std::thread setter_thread;
+    std::vector<decltype(pollcoro::single_event<int>())> events;
+    events.reserve(rounds);
+    for (int i = 0; i < rounds; ++i) {
+        events.push_back(pollcoro::single_event<int>());
+    }
+
+    setter_thread = std::thread([&] {
+        for (int i = 0; i < rounds; ++i) {
+            while (round.load(std::memory_order_acquire) != i) {
+            }
+            // Give the waiter time to block before setting
+            auto until = bench::clock::now() + std::chrono::microseconds(20);
+            while (bench::clock::now() < until) {
+            }
+            set_at.store(
+                bench::clock::now().time_since_epoch().count(), std::memory_order_release
+            );
+            std::get<1>(events[i]).set(i);
+        }
+    });
+
+    auto start = bench::clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        round.store(i, std::memory_order_release);
+        bench::do_not_optimize(pollcoro::block_on(std::move(std::get<0>(events[i]))));
+        auto resumed = bench::clock::now().time_since_epoch().count();
+        latencies.record(
+            static_cast<std::uint64_t>(resumed - set_at.load(std::memory_order_acquire))
+        );
+    }
+    auto total = bench::elapsed_ns(start, bench::clock::now());
+    setter_thread.join();
+
+    bench::result result{name, rounds, total / rounds};
+    latencies.summarize(result);
+    r.report(result);
+}
+
+void bench_mutex(bench::runner& r) {
+    r.run("mutex/uncontended", [](std::uint64_t n) {
+        pollcoro::mutex mtx;
+        auto t = [](pollcoro::mutex& mtx, std::uint64_t n) -> pollcoro::task<> {
+            for (std::uint64_t i = 0; i < n; ++i) {
+                auto guard = co_await mtx.lock();
+                bench::clobber_memory();
+            }
+        }(mtx, n);
+        poll_to_completion(t);
+    });
+
+    r.run("mutex/try_lock", [](std::uint64_t n) {
+        pollcoro::mutex mtx;
+        for (std::uint64_t i = 0; i < n; ++i) {
+            auto guard = mtx.try_lock();
+            bench::do_not_optimize(guard);
+        }
+    });
+
+    auto threads = std::max(2u, std::min(8u, std::thread::hardware_concurrency()));
+    auto name = "mutex/contended/threads:" + std::to_string(threads);
+    if (r.enabled(name)) {
+        // Each operation is one lock/unlock by any of the threads
+        auto result = r.measure(name, [&](std::uint64_t n) {
+            pollcoro::mutex mtx;
+            std::uint64_t counter = 0;
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < threads; ++t) {
+                auto ops = n / threads + (t < n % threads ? 1 : 0);
+                workers.emplace_back([&, ops] {
+                    pollcoro::block_on([](pollcoro::mutex& mtx, std::uint64_t& counter,
+                                          std::uint64_t ops) -> pollcoro::task<> {
+                        for (std::uint64_t i = 0; i < ops; ++i) {
+                            auto guard = co_await mtx.lock();
+                            ++counter;
+                        }
+                    }(mtx, counter, ops));
+                });
+            }
+            for (auto& w : workers) {
+                w.join();
+            }
+            bench::do_not_optimize(counter);
+        });
+        result.add("ops_per_sec", 1e9 / result.ns_per_op);
+        r.report(result);
+    }
+}
+
+void bench_wait_all(bench::runner& r) {
+    for (std::size_t children : {std::size_t(10), std::size_t(1000), std::size_t(100000)}) {
+        auto name = "wait_all/children:" + std::to_string(children);
+        if (!r.enabled(name)) {
+            continue;
+        }
+        // One operation is one wait_all over every child, each of which is
+        // pending once before completing
+        auto result = r.measure(name, [&](std::uint64_t n) {
+            for (std::uint64_t i = 0; i < n; ++i) {
+                std::vector<pollcoro::task<>> tasks;
+                tasks.reserve(children);
+                for (std::size_t c = 0; c < children; ++c) {
+                    tasks.push_back([]() -> pollcoro::task<> {
+                        co_await countdown(1);
+                    }());
+                }
+                auto all = pollcoro::wait_all(tasks);
+                poll_to_completion(all);
+            }
+        });
+        result.add("ns_per_child", result.ns_per_op / static_cast<double>(children));
+        r.report(result);
+    }
+}
+
+void bench_stream(bench::runner& r) {
+    r.run("stream/range|map|take|window<4>", [](std::uint64_t n) {
+        auto pipeline = pollcoro::range(std::uint64_t(0), n) | pollcoro::map([](std::uint64_t x) {
+                            return x * 3;
+                        }) |
+            pollcoro::take(n) | pollcoro::window<4>();
+        auto sum = pollcoro::fold(std::move(pipeline), std::uint64_t(0), [](auto& acc, auto w) {
+            acc += w[0] + w[3];
+        });
+        bench::do_not_optimize(poll_to_completion(sum).take_result());
+    });
+
+    r.run("stream/coroutine|map|take|window<4>", [](std::uint64_t n) {
+        auto source = [](std::uint64_t n) -> pollcoro::stream<std::uint64_t> {
+            for (std::uint64_t i = 0; i < n; ++i) {
+                co_yield i;
+            }
+        }(n);
+        auto pipeline = std::move(source) | pollcoro::map([](std::uint64_t x) {
+                            return x * 3;
+                        }) |
+            pollcoro::take(n) | pollcoro::window<4>();
+        auto sum = pollcoro::fold(std::move(pipeline), std::uint64_t(0), [](auto& acc, auto w) {
+            acc += w[0] + w[3];
+        });
+        bench::do_not_optimize(poll_to_completion(sum).take_result());
+    });
+}
+
+int main(int argc, char** argv) {
+    bench::runner r(argc, argv);
+    bench_task(r);
+    bench_await_chain(r);
+    bench_block_on(r);
+    bench_single_event(r);
+    bench_mutex(r);
+    bench_wait_all(r);
+    bench_stream(r);
+}
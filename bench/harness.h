@@ -0,0 +1,368 @@
+/**
+ * Minimal benchmark harness shared by the pollcoro benchmarks.
+ *
+ * Every benchmark reports one result per case. Results are printed as an
+ * aligned table by default, or as JSON lines with `--json` so that runs can be
+ * diffed and tracked by scripts. `--filter=<substring>` selects cases and
+ * `--min-time=<seconds>` sets how long each case is repeated for. Benchmarks
+ * may accept further `--<name>=<value>` options, declared when constructing
+ * the runner.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace pollcoro_bench {
+
+using clock = std::chrono::steady_clock;
+
+template<typename T>
+inline void do_not_optimize(T const& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobber_memory() {
+    asm volatile("" : : : "memory");
+}
+
+inline double elapsed_ns(clock::time_point start, clock::time_point end) {
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+struct result {
+    std::string name;
+    std::uint64_t iterations = 0;
+    double ns_per_op = 0;
+    std::vector<std::pair<std::string, double>> counters;
+
+    result& add(std::string key, double value) {
+        counters.emplace_back(std::move(key), value);
+        return *this;
+    }
+};
+
+/// Counts user-space instructions retired by the calling thread, through
+/// `perf_event_open`. Where the counter cannot be opened (not Linux, no PMU in
+/// a VM or container, `perf_event_paranoid` too strict) `available()` is false
+/// and benchmarks should omit instruction counts rather than fail.
+class instruction_counter {
+    int fd_ = -1;
+
+  public:
+    instruction_counter() {
+#if defined(__linux__)
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    instruction_counter(const instruction_counter&) = delete;
+    instruction_counter& operator=(const instruction_counter&) = delete;
+
+    ~instruction_counter() {
+#if defined(__linux__)
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+#endif
+    }
+
+    bool available() const {
+        return fd_ >= 0;
+    }
+
+    void start() {
+#if defined(__linux__)
+        ::ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ::ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    /// Returns the instructions retired since `start()`.
+    std::uint64_t stop() {
+        std::uint64_t count = 0;
+#if defined(__linux__)
+        ::ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        if (::read(fd_, &count, sizeof(count)) != sizeof(count)) {
+            count = 0;
+        }
+#endif
+        return count;
+    }
+};
+
+class runner {
+    bool json_ = false;
+    std::string filter_;
+    double min_time_ = 0.25;
+    bool header_printed_ = false;
+    std::vector<std::pair<std::string, std::string>> options_;
+
+    void print(const result& r) {
+        if (json_) {
+            std::printf(
+                "{\"name\":\"%s\",\"iterations\":%llu,\"ns_per_op\":%.3f",
+                r.name.c_str(),
+                static_cast<unsigned long long>(r.iterations),
+                r.ns_per_op
+            );
+            for (auto& [key, value] : r.counters) {
+                std::printf(",\"%s\":%.3f", key.c_str(), value);
+            }
+            std::printf("}\n");
+        } else {
+            if (!header_printed_) {
+                std::printf(
+                    "%-48s %14s %14s  %s\n", "benchmark", "iterations", "ns/op", "counters"
+                );
+                header_printed_ = true;
+            }
+            std::printf(
+                "%-48s %14llu %14.2f ",
+                r.name.c_str(),
+                static_cast<unsigned long long>(r.iterations),
+                r.ns_per_op
+            );
+            for (auto& [key, value] : r.counters) {
+                std::printf(" %s=%.2f", key.c_str(), value);
+            }
+            std::printf("\n");
+        }
+        std::fflush(stdout);
+    }
+
+    bool parse_extra(std::string_view arg, std::initializer_list<std::string_view> extra) {
+        for (auto name : extra) {
+            if (arg.size() > name.size() + 3 && arg.starts_with("--") &&
+                arg.substr(2, name.size()) == name && arg[name.size() + 2] == '=') {
+                options_.emplace_back(name, arg.substr(name.size() + 3));
+                return true;
+            }
+        }
+        return false;
+    }
+
+  public:
+    /// `extra` names the additional `--<name>=<value>` options the benchmark
+    /// accepts; read them with `option()`.
+    runner(int argc, char** argv, std::initializer_list<std::string_view> extra = {}) {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            if (arg == "--json") {
+                json_ = true;
+            } else if (arg.starts_with("--filter=")) {
+                filter_ = arg.substr(9);
+            } else if (arg.starts_with("--min-time=")) {
+                min_time_ = std::strtod(argv[i] + 11, nullptr);
+            } else if (!parse_extra(arg, extra)) {
+                std::fprintf(
+                    stderr, "usage: %s [--json] [--filter=<substring>] [--min-time=<s>]", argv[0]
+                );
+                for (auto name : extra) {
+                    std::fprintf(
+                        stderr,
+                        " [--%.*s=<value>]",
+                        static_cast<int>(name.size()),
+                        name.data()
+                    );
+                }
+                std::fprintf(stderr, "\n");
+                std::exit(2);
+            }
+        }
+    }
+
+    /// Returns the value of an extra option, or `fallback` if it was not given.
+    double option(std::string_view name, double fallback) const {
+        for (auto& [key, value] : options_) {
+            if (key == name) {
+                return std::strtod(value.c_str(), nullptr);
+            }
+        }
+        return fallback;
+    }
+
+    bool json() const {
+        return json_;
+    }
+
+    bool enabled(std::string_view name) const {
+        return filter_.empty() || name.find(filter_) != std::string_view::npos;
+    }
+
+    double min_time() const {
+        return min_time_;
+    }
+
+    /// Times `body(n)`, which must perform `n` operations, growing `n` until a
+    /// run takes at least the minimum time. Returns the result so callers can
+    /// attach counters before reporting it.
+    template<typename Body>
+    result measure(std::string name, Body&& body) {
+        result r{std::move(name)};
+        std::uint64_t n = 1;
+        while (true) {
+            auto start = clock::now();
+            body(n);
+            auto ns = elapsed_ns(start, clock::now());
+            if (ns >= min_time_ * 1e9 || n >= (std::uint64_t(1) << 40)) {
+                r.iterations = n;
+                r.ns_per_op = ns / static_cast<double>(n);
+                return r;
+            }
+            // Aim slightly past the minimum time to avoid another round
+            auto target = ns > 0 ? min_time_ * 1.2e9 / ns * static_cast<double>(n) : n * 10.0;
+            n = std::max<std::uint64_t>(n + 1, std::min<double>(target, n * 100.0));
+        }
+    }
+
+    /// Measures and reports `body` if `name` passes the filter.
+    template<typename Body>
+    void run(std::string name, Body&& body) {
+        if (enabled(name)) {
+            report(measure(std::move(name), std::forward<Body>(body)));
+        }
+    }
+
+    void report(const result& r) {
+        print(r);
+    }
+};
+
+/// Collects latency samples and summarizes them as percentiles.
+class histogram {
+    std::vector<std::uint64_t> samples_;
+
+  public:
+    void reserve(std::size_t n) {
+        samples_.reserve(n);
+    }
+
+    void record(std::uint64_t ns) {
+        samples_.push_back(ns);
+    }
+
+    std::size_t size() const {
+        return samples_.size();
+    }
+
+    /// Adds mean, p50, p90, p99, p999 and max (all in ns) to `r`.
+    void summarize(result& r) {
+        if (samples_.empty()) {
+            return;
+        }
+        std::sort(samples_.begin(), samples_.end());
+        double sum = 0;
+        for (auto s : samples_) {
+            sum += static_cast<double>(s);
+        }
+        auto at = [&](double q) {
+            auto i = static_cast<std::size_t>(q * static_cast<double>(samples_.size() - 1));
+            return static_cast<double>(samples_[i]);
+        };
+        r.add("mean_ns", sum / static_cast<double>(samples_.size()))
+            .add("p50_ns", at(0.5))
+            .add("p90_ns", at(0.9))
+            .add("p99_ns", at(0.99))
+            .add("p999_ns", at(0.999))
+            .add("max_ns", static_cast<double>(samples_.back()));
+    }
+};
+
+/// Counts samples in power-of-two buckets: bucket `i` holds values in
+/// `[2^(i-1), 2^i)` and bucket 0 holds zero. Recording is a handful of
+/// instructions with no allocation, and per-thread histograms can be merged,
+/// so it suits hot paths where keeping every sample in `histogram` would
+/// perturb what is being measured. Percentiles are reported as the upper
+/// bound of the bucket they fall in.
+class log2_histogram {
+    std::array<std::uint64_t, 65> buckets_{};
+    std::uint64_t count_ = 0;
+    std::uint64_t max_ = 0;
+
+    static double upper_bound(std::size_t bucket) {
+        return bucket == 0 ? 0.0 : std::ldexp(1.0, static_cast<int>(bucket)) - 1;
+    }
+
+  public:
+    void record(std::uint64_t ns) {
+        ++buckets_[std::bit_width(ns)];
+        ++count_;
+        max_ = std::max(max_, ns);
+    }
+
+    void merge(const log2_histogram& other) {
+        for (std::size_t i = 0; i < buckets_.size(); ++i) {
+            buckets_[i] += other.buckets_[i];
+        }
+        count_ += other.count_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    std::uint64_t size() const {
+        return count_;
+    }
+
+    double quantile(double q) const {
+        auto target = static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(count_)));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < buckets_.size(); ++i) {
+            seen += buckets_[i];
+            if (seen >= target && seen > 0) {
+                return std::min(upper_bound(i), static_cast<double>(max_));
+            }
+        }
+        return static_cast<double>(max_);
+    }
+
+    /// Adds `<prefix>_p50_ns`, `_p90_ns`, `_p99_ns`, `_p999_ns` and `_max_ns`.
+    void summarize(result& r, const std::string& prefix) const {
+        if (count_ == 0) {
+            return;
+        }
+        r.add(prefix + "_p50_ns", quantile(0.5))
+            .add(prefix + "_p90_ns", quantile(0.9))
+            .add(prefix + "_p99_ns", quantile(0.99))
+            .add(prefix + "_p999_ns", quantile(0.999))
+            .add(prefix + "_max_ns", static_cast<double>(max_));
+    }
+
+    /// Adds one `<prefix>_lt_<bound>ns` count per non-empty bucket.
+    void buckets(result& r, const std::string& prefix) const {
+        for (std::size_t i = 0; i < buckets_.size(); ++i) {
+            if (buckets_[i] == 0) {
+                continue;
+            }
+            auto bound = i < 64 ? std::to_string(std::uint64_t(1) << i) : std::string("inf");
+            r.add(prefix + "_lt_" + bound + "ns", static_cast<double>(buckets_[i]));
+        }
+    }
+};
+
+}  // namespace pollcoro_bench
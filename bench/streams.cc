@@ -0,0 +1,576 @@
+/**
+ * Stream pipeline throughput against hand-written loops and std::views.
+ *
+ * Every combinator is run over an in-memory vector of 4B, 64B and 4KB items in
+ * three forms: a raw loop, the equivalent std::views pipeline where C++20 has
+ * one, and a pollcoro pipeline fed by `iter()` and drained by `fold()`. All
+ * three compute the same checksum, which is verified before timing. A
+ * composite `map | take | window` case checks that stages still fuse when
+ * stacked.
+ *
+ * Throughput is reported per source item. Since nothing in these pipelines
+ * ever blocks, a pollcoro pipeline that inlines fully compiles down to
+ * roughly the raw loop; pipelines slower than `--max-ratio` (default 1.5)
+ * times the raw loop are flagged and listed at the end.
+ *
+ * The raw loops are written the obvious way and the optimizer is free to
+ * shrink them: copies of large items whose fields go unused disappear, and
+ * `last`/`nth` collapse to a single load. Ratios far above 1 mean the pollcoro
+ * pipeline still performs that work.
+ */
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "harness.h"
+
+import pollcoro;
+
+namespace bench = pollcoro_bench;
+
+// =============================================================================
+// Items
+// =============================================================================
+
+template<std::size_t Bytes>
+struct item {
+    std::array<std::uint32_t, Bytes / 4> words;
+};
+
+template<std::size_t Bytes>
+std::uint64_t key(const item<Bytes>& x) {
+    return x.words.front() + x.words.back();
+}
+
+// Copy of `x` with one word changed, so that a stage mapping items to items
+// still moves the whole payload along
+template<std::size_t Bytes>
+item<Bytes> scaled(item<Bytes> x) {
+    x.words.front() *= 3;
+    return x;
+}
+
+struct key_fn {
+    template<std::size_t Bytes>
+    std::uint64_t operator()(const item<Bytes>& x) const {
+        return key(x);
+    }
+};
+
+template<std::size_t Bytes>
+std::vector<item<Bytes>> make_items(std::size_t count) {
+    std::vector<item<Bytes>> items(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        items[i].words.fill(static_cast<std::uint32_t>(i));
+    }
+    return items;
+}
+
+// =============================================================================
+// Drivers
+// =============================================================================
+
+template<typename Awaitable>
+auto drain(Awaitable awaitable) {
+    while (true) {
+        auto state = awaitable.poll(pollcoro::waker());
+        if (state.is_ready()) {
+            return state.take_result();
+        }
+    }
+}
+
+template<typename Stream, typename Proj>
+std::uint64_t fold_sum(Stream stream, Proj proj) {
+    return drain(pollcoro::fold(
+        std::move(stream), std::uint64_t(0), [proj](std::uint64_t& acc, const auto& x) {
+            acc += proj(x);
+        }
+    ));
+}
+
+template<typename Range, typename Proj>
+std::uint64_t range_sum(Range&& range, Proj proj) {
+    std::uint64_t acc = 0;
+    for (auto&& x : range) {
+        acc += proj(x);
+    }
+    return acc;
+}
+
+template<typename T>
+auto source(const std::vector<T>& items) {
+    return pollcoro::iter(items.begin(), items.end());
+}
+
+template<typename T>
+struct pipeline {
+    using fn = std::uint64_t (*)(const std::vector<T>&);
+
+    const char* name;
+    fn raw;
+    fn views;  // nullptr if C++20 has no equivalent view
+    fn pollcoro;
+};
+
+template<typename T>
+std::vector<pipeline<T>> pipelines() {
+    using items_t = std::vector<T>;
+    constexpr std::size_t chunk = 16;
+
+    return {
+        {
+            "fold",
+            [](const items_t& items) {
+                std::uint64_t acc = 0;
+                for (std::size_t i = 0; i < items.size(); ++i) {
+                    T x = items[i];
+                    acc += key(x);
+                }
+                return acc;
+            },
+            [](const items_t& items) {
+                return range_sum(items | std::views::all, key_fn());
+            },
+            [](const items_t& items) {
+                return fold_sum(source(items), key_fn());
+            },
+        },
+        {
+            "map",
+            [](const items_t& items) {
+                std::uint64_t acc = 0;
+                for (std::size_t i = 0; i < items.size(); ++i) {
+                    T x = items[i];
+                    acc += key(x) * 3;
+                }
+                return acc;
+            },
+            [](const items_t& items) {
+                return range_sum(
+                    items | std::views::transform([](const T& x) {
+                        return key(x) * 3;
+                    }),
+                    std::identity()
+                );
+            },
+            [](const items_t& items) {
+                return fold_sum(
+                    source(items) | pollcoro::map([](const T& x) {
+                        return key(x) * 3;
+                    }),
+                    std::identity()
+                );
+            },
+        },
+        {
+            "take",
+            [](const items_t& items) {
+                std::uint64_t acc = 0;
+                for (std::size_t i = 0; i < items.size() / 2; ++i) {
+                    T x = items[i];
+                    acc += key(x);
+                }
+                return acc;
+            },
+            [](const items_t& items) {
+                return range_sum(items | std::views::take(items.size() / 2), key_fn());
+            },
+            [](const items_t& items) {
+                return fold_sum(source(items) | pollcoro::take(items.size() / 2), key_fn());
+            },
+        },
+        {
+            "skip",
+            [](const items_t& items) {
+                std::uint64_t acc = 0;
+                for (std::size_t i = items.size() / 2; i < items.size(); ++i) {
+                    T x = items[i];
+                    acc += key(x);
+                }
+                return acc;
+            },
+            [](const items_t& items) {
+                return range_sum(items | std::views::drop(items.size() / 2), key_fn());
+            },
+            [](const items_t& items) {
+                return fold_sum(source(items) | pollcoro::skip(items.size() / 2), key_fn());
+            },
+        },
+        {
+            "skip_while",
+            [](const items_t& items) {
+                std::uint64_t acc = 0;
+                std::size_t i = 0;
+                while (i < items.size() && key(items[i]) < items.size()) {
+                    ++i;
+                }
+                for (; i < items.size(); ++i) {
+                    T x = items[i];
+                    acc += key(x);
+                }
+                return acc;
+            },
+            [](const items_t& items) {
+                auto limit = items.size();
+                return range_sum(
+                    items | std::views::drop_while([limit](const T& x) {
+                        return key(x) < limit;
+                    }),
+                    key_fn()
+                );
+            },
+            [](const items_t& items) {
+                auto limit = items.size();
+                return fold_sum(
+                    source(items) | pollcoro::skip_while([limit](const T& x) {
+                        return key(x) < limit;
+                    }),
+                    key_fn()
+                );
+            },
+        },
+        {
+            "take_while",
+            [](const items_t& items) {
+                std::uint64_t acc = 0;
+                for (std::size_t i = 0; i < items.size(); ++i) {
+                    T x = items[i];
+                    if (key(x) >= items.size()) {
+                        break;
+                    }
+                    acc += key(x);
+                }
+                return acc;
+            },
+            [](const items_t& items) {
+                auto limit = items.size();
+                return range_sum(
+                    items | std::views::take_while([limit](const T& x) {
+                        return key(x) < limit;
+                    }),
+                    key_fn()
+                );
+            },
+            [](const items_t& items) {
+                auto limit = items.size();
+                return fold_sum(
+                    source(items) | pollcoro::take_while([limit](const T& x) {
+                        return key(x) < limit;
+                    }),
+                    key_fn()
+                );
+            },
+        },
+        {
+            "chain",
+            [](const items_t& items) {
+                std::uint64_t acc = 0;
+                auto mid = items.size() / 2;
+                for (std::size_t i = 0; i < mid; ++i) {
+                    T x = items[i];
+                    acc += key(x);
+                }
+                for (std::size_t i = mid; i < items.size(); ++i) {
+                    T x = items[i];
+                    acc += key(x);
+                }
+                return acc;
+            },
+            nullptr,
+            [](const items_t& items) {
+                auto mid = items.begin() + static_cast<std::ptrdiff_t>(items.size() / 2);
+                return fold_sum(
+                    pollcoro::chain(
+                        pollcoro::iter(items.begin(), mid), pollcoro::iter(mid, items.end())
+                    ),
+                    key_fn()
+                );
+            },
+        },
+        {
+            "zip",
+            [](const items_t& items) {
+                std::uint64_t acc = 0;
+                for (std::size_t i = 0; i < items.size(); ++i) {
+                    T x = items[i];
+                    T y = items[items.size() - 1 - i];
+                    acc += key(x) ^ key(y);
+                }
+                return acc;
+            },
+            nullptr,
+            [](const items_t& items) {
+                return fold_sum(
+                    pollcoro::zip(source(items), pollcoro::iter(items.rbegin(), items.rend())),
+                    [](const std::tuple<T, T>& xy) {
+                        return key(std::get<0>(xy)) ^ key(std::get<1>(xy));
+                    }
+                );
+            },
+        },
+        {
+            "flatten",
+            [](const items_t& items) {
+                std::uint64_t acc = 0;
+                for (std::size_t c = 0; c < items.size() / chunk; ++c) {
+                    for (std::size_t i = c * chunk; i < (c + 1) * chunk; ++i) {
+                        T x = items[i];
+                        acc += key(x);
+                    }
+                }
+                return acc;
+            },
+            [](const items_t& items) {
+                return range_sum(
+                    std::views::iota(std::size_t(0), items.size() / chunk) |
+                        std::views::transform([&items](std::size_t c) {
+                            return std::ranges::subrange(
+                                items.begin() + static_cast<std::ptrdiff_t>(c * chunk),
+                                items.begin() + static_cast<std::ptrdiff_t>((c + 1) * chunk)
+                            );
+                        }) |
+                        std::views::join,
+                    key_fn()
+                );
+            },
+            [](const items_t& items) {
+                return fold_sum(
+                    pollcoro::range(std::size_t(0), items.size() / chunk) |
+                        pollcoro::map([&items](std::size_t c) {
+                            return pollcoro::iter(
+                                items.begin() + static_cast<std::ptrdiff_t>(c * chunk),
+                                items.begin() + static_cast<std::ptrdiff_t>((c + 1) * chunk)
+                            );
+                        }) |
+                        pollcoro::flatten(),
+                    key_fn()
+                );
+            },
+        },
+        {
+            "window<4>",
+            [](const items_t& items) {
+                std::uint64_t acc = 0;
+                for (std::size_t i = 0; i + 4 <= items.size(); i += 4) {
+                    std::array<T, 4> w{items[i], items[i + 1], items[i + 2], items[i + 3]};
+                    acc += key(w[0]) + key(w[3]);
+                }
+                return acc;
+            },
+            nullptr,
+            [](const items_t& items) {
+                return fold_sum(
+                    source(items) | pollcoro::window<4>(),
+                    [](const std::array<T, 4>& w) {
+                        return key(w[0]) + key(w[3]);
+                    }
+                );
+            },
+        },
+        {
+            "map_take_window<4>",
+            [](const items_t& items) {
+                std::uint64_t acc = 0;
+                auto n = items.size() / 2;
+                for (std::size_t i = 0; i + 4 <= n; i += 4) {
+                    std::array<T, 4> w{
+                        scaled(items[i]),
+                        scaled(items[i + 1]),
+                        scaled(items[i + 2]),
+                        scaled(items[i + 3]),
+                    };
+                    acc += key(w[0]) + key(w[3]);
+                }
+                return acc;
+            },
+            [](const items_t& items) {
+                // C++20 has no chunk view, so windows are formed by hand
+                std::uint64_t acc = 0;
+                std::array<T, 4> w;
+                std::size_t filled = 0;
+                for (auto&& x : items | std::views::transform([](const T& x) {
+                                    return scaled(x);
+                                }) | std::views::take(items.size() / 2)) {
+                    w[filled++] = x;
+                    if (filled == 4) {
+                        acc += key(w[0]) + key(w[3]);
+                        filled = 0;
+                    }
+                }
+                return acc;
+            },
+            [](const items_t& items) {
+                return fold_sum(
+                    source(items) |
+                        pollcoro::map([](const T& x) {
+                            return scaled(x);
+                        }) |
+                        pollcoro::take(items.size() / 2) | pollcoro::window<4>(),
+                    [](const std::array<T, 4>& w) {
+                        return key(w[0]) + key(w[3]);
+                    }
+                );
+            },
+        },
+        {
+            "enumerate",
+            [](const items_t& items) {
+                std::uint64_t acc = 0;
+                for (std::size_t i = 0; i < items.size(); ++i) {
+                    T x = items[i];
+                    acc += i * key(x);
+                }
+                return acc;
+            },
+            nullptr,
+            [](const items_t& items) {
+                return fold_sum(
+                    source(items) | pollcoro::enumerate(),
+                    [](const std::pair<std::size_t, T>& p) {
+                        return p.first * key(p.second);
+                    }
+                );
+            },
+        },
+        {
+            "last",
+            [](const items_t& items) {
+                T last{};
+                for (std::size_t i = 0; i < items.size(); ++i) {
+                    last = items[i];
+                }
+                return key(last);
+            },
+            nullptr,
+            [](const items_t& items) {
+                return key(*drain(pollcoro::last(source(items))));
+            },
+        },
+        {
+            "nth",
+            [](const items_t& items) {
+                T nth{};
+                for (std::size_t i = 0; i < items.size(); ++i) {
+                    nth = items[i];
+                }
+                return key(nth);
+            },
+            nullptr,
+            [](const items_t& items) {
+                auto stream = source(items);
+                return key(*drain(pollcoro::nth(stream, items.size())));
+            },
+        },
+    };
+}
+
+// =============================================================================
+// Measurement
+// =============================================================================
+
+struct context {
+    bench::runner& runner;
+    bench::instruction_counter& instructions;
+    double max_ratio;
+    std::vector<std::string> flagged;
+};
+
+template<typename T>
+bench::result measure(context& ctx, const std::string& name, auto fn, const std::vector<T>& items) {
+    // Each operation is one pass over every item; report per item instead
+    auto result = ctx.runner.measure(name, [&](std::uint64_t passes) {
+        for (std::uint64_t i = 0; i < passes; ++i) {
+            bench::do_not_optimize(fn(items));
+        }
+    });
+    auto count = static_cast<double>(items.size());
+    result.iterations *= items.size();
+    result.ns_per_op /= count;
+    result.add("items_per_sec", 1e9 / result.ns_per_op);
+
+    if (ctx.instructions.available()) {
+        constexpr int passes = 8;
+        ctx.instructions.start();
+        for (int i = 0; i < passes; ++i) {
+            bench::do_not_optimize(fn(items));
+        }
+        auto retired = ctx.instructions.stop();
+        result.add("instructions_per_item", static_cast<double>(retired) / (passes * count));
+    }
+    return result;
+}
+
+template<std::size_t Bytes>
+void bench_item_size(context& ctx, std::size_t count) {
+    using T = item<Bytes>;
+    auto items = make_items<Bytes>(count);
+    auto suffix = "/item:" + std::to_string(Bytes) + "B";
+
+    for (auto& p : pipelines<T>()) {
+        auto prefix = std::string("streams/") + p.name;
+        auto raw_name = prefix + "/raw" + suffix;
+        auto views_name = prefix + "/views" + suffix;
+        auto pollcoro_name = prefix + "/pollcoro" + suffix;
+        if (!ctx.runner.enabled(raw_name) && !ctx.runner.enabled(pollcoro_name) &&
+            !(p.views && ctx.runner.enabled(views_name))) {
+            continue;
+        }
+
+        auto expected = p.raw(items);
+        if ((p.views && p.views(items) != expected) || p.pollcoro(items) != expected) {
+            std::fprintf(stderr, "%s: checksum mismatch\n", prefix.c_str());
+            std::exit(1);
+        }
+
+        // The raw loop is the baseline for the ratios even when filtered out
+        auto raw = measure(ctx, raw_name, p.raw, items);
+        if (ctx.runner.enabled(raw_name)) {
+            ctx.runner.report(raw);
+        }
+
+        if (p.views && ctx.runner.enabled(views_name)) {
+            auto views = measure(ctx, views_name, p.views, items);
+            views.add("ratio_to_raw", views.ns_per_op / raw.ns_per_op);
+            ctx.runner.report(views);
+        }
+
+        if (ctx.runner.enabled(pollcoro_name)) {
+            auto pollcoro = measure(ctx, pollcoro_name, p.pollcoro, items);
+            auto ratio = pollcoro.ns_per_op / raw.ns_per_op;
+            pollcoro.add("ratio_to_raw", ratio);
+            if (ratio > ctx.max_ratio) {
+                pollcoro.add("flagged", 1);
+                ctx.flagged.push_back(pollcoro_name + " (" + std::to_string(ratio) + "x)");
+            }
+            ctx.runner.report(pollcoro);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    bench::runner r(argc, argv, {"max-ratio"});
+    bench::instruction_counter instructions;
+    if (!instructions.available()) {
+        std::fprintf(stderr, "perf_event_open unavailable; not reporting instructions per item\n");
+    }
+
+    context ctx{r, instructions, r.option("max-ratio", 1.5), {}};
+    // At most 256KB per item size, so the data stays cache-resident
+    bench_item_size<4>(ctx, 16384);
+    bench_item_size<64>(ctx, 2048);
+    bench_item_size<4096>(ctx, 64);
+
+    if (!ctx.flagged.empty()) {
+        std::fprintf(stderr, "\npipelines slower than %.2fx the raw loop:\n", ctx.max_ratio);
+        for (auto& name : ctx.flagged) {
+            std::fprintf(stderr, "  %s\n", name.c_str());
+        }
+    }
+}
@@ -0,0 +1,102 @@
+/*
+ * Channel Example
+ *
+ * Demonstrates pollcoro::channel for handing values from producer threads
+ * to a pollcoro pipeline. The channel is bounded, so fast producers are
+ * held back (backpressure) when the consumer falls behind.
+ */
+
+#include <coroutine>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+import pollcoro;
+
+// =============================================================================
+// Example 1: Producer threads feeding a stream pipeline
+// =============================================================================
+
+void test_threaded_producers() {
+    std::cout << "=== Threaded producers ===" << std::endl;
+
+    auto [tx, rx] = pollcoro::channel<int>(16);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 4; ++p) {
+        producers.emplace_back([tx, p]() mutable {
+            for (int i = 0; i < 1000; ++i) {
+                // block_on waits while the channel is full
+                pollcoro::block_on(tx.send(p * 1000 + i));
+            }
+        });
+    }
+    {
+        // Drop our own sender so the stream finishes when the producers do
+        auto dropped = std::move(tx);
+    }
+
+    auto sum = pollcoro::block_on(pollcoro::fold(
+        std::move(rx) | pollcoro::map([](int v) {
+            return static_cast<long long>(v);
+        }),
+        0LL,
+        [](long long& acc, long long v) {
+            acc += v;
+        }
+    ));
+
+    for (auto& t : producers) {
+        t.join();
+    }
+
+    std::cout << "Sum: " << sum << std::endl;
+    std::cout << "Expected: " << (4000LL * 3999 / 2) << std::endl;
+    std::cout << std::endl;
+}
+
+// =============================================================================
+// Example 2: Task-to-task with batched receive
+// =============================================================================
+
+pollcoro::task<> producer(pollcoro::channel_sender<int> tx) {
+    // Coroutine parameters live as long as the task object, so move the sender
+    // into a local to close the channel as soon as this body finishes.
+    auto sender = std::move(tx);
+    for (int i = 0; i < 10; ++i) {
+        co_await sender.send(i);
+    }
+}
+
+pollcoro::task<> consumer(pollcoro::channel_receiver<int> rx) {
+    std::vector<int> batch;
+    while (true) {
+        batch.clear();
+        if (rx.try_recv_many(std::back_inserter(batch), 4) == 0) {
+            // Nothing buffered, wait for the next value (or the end)
+            auto value = co_await pollcoro::next(rx);
+            if (!value) {
+                break;
+            }
+            batch.push_back(*value);
+        }
+        std::cout << "  Batch:";
+        for (int v : batch) {
+            std::cout << " " << v;
+        }
+        std::cout << std::endl;
+    }
+}
+
+pollcoro::task<> test_batched_receive() {
+    std::cout << "=== Batched receive ===" << std::endl;
+    auto [tx, rx] = pollcoro::channel<int>(4);
+    co_await pollcoro::wait_all(producer(std::move(tx)), consumer(std::move(rx)));
+    std::cout << std::endl;
+}
+
+int main() {
+    test_threaded_producers();
+    pollcoro::block_on(test_batched_receive());
+    return 0;
+}
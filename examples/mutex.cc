@@ -1,8 +1,9 @@
 /*
  * Mutex Example
  *
- * Demonstrates pollcoro::mutex and pollcoro::shared_mutex for safe
- * synchronization across yield points.
+ * Demonstrates pollcoro::mutex, pollcoro::shared_mutex, pollcoro::semaphore
+ * and pollcoro::condition_variable for safe synchronization across yield
+ * points.
  *
  * Standard mutexes (std::mutex) are unsafe to hold across co_await because
  * a mutex can only be unlocked on the same thread that locked it, but after
@@ -210,22 +211,16 @@ struct cache {
     }
 
     pollcoro::task<int> get_or_compute(const std::string& key, int default_value) {
-        // First try with read lock
-        {
-            auto guard = co_await mtx.lock_shared();
-            auto it = data.find(key);
-            if (it != data.end()) {
-                co_return it->second;
-            }
-        }
-
-        // Not found - need write lock to insert
-        auto guard = co_await mtx.lock();
-        // Double-check after acquiring write lock
+        // An upgradable lock lets other readers in but no other upgrader, so
+        // nobody can insert the key between our lookup and our write
+        auto guard = co_await mtx.lock_upgradable();
         auto it = data.find(key);
         if (it != data.end()) {
             co_return it->second;
         }
+
+        // Not found - upgrade in place, no need to look the key up again
+        auto writer = co_await guard.upgrade();
         data[key] = default_value;
         co_return default_value;
     }
@@ -314,6 +309,85 @@ pollcoro::task<> test_fairness() {
     std::cout << std::endl;
 }
 
+// =============================================================================
+// Example 8: semaphore - limiting concurrency
+// =============================================================================
+
+pollcoro::semaphore request_slots(2);
+int in_flight = 0;
+
+pollcoro::task<> limited_request(int id) {
+    auto permit = co_await request_slots.acquire();
+    ++in_flight;
+    std::cout << "  Request " << id << " started (" << in_flight << " in flight)" << std::endl;
+    co_await pollcoro::yield(2);  // Simulate the request
+    --in_flight;
+    std::cout << "  Request " << id << " finished" << std::endl;
+}
+
+pollcoro::task<> batch_request() {
+    // Weighted acquire: waits until both slots are free at once
+    auto permit = co_await request_slots.acquire(2);
+    std::cout << "  Batch request holds " << permit.count() << " permits" << std::endl;
+    co_await pollcoro::yield();
+}
+
+pollcoro::task<> test_semaphore() {
+    std::cout << "=== semaphore (at most 2 requests in flight) ===" << std::endl;
+
+    co_await pollcoro::wait_all(
+        limited_request(1), limited_request(2), batch_request(), limited_request(3)
+    );
+
+    std::cout << "Permits available afterwards: " << request_slots.available_permits()
+              << std::endl;
+    std::cout << std::endl;
+}
+
+// =============================================================================
+// Example 9: condition_variable - waiting for a condition under the mutex
+// =============================================================================
+
+pollcoro::mutex queue_mtx;
+pollcoro::condition_variable queue_cv;
+std::vector<int> work_queue;
+bool queue_closed = false;
+
+pollcoro::task<> queue_consumer() {
+    auto guard = co_await queue_mtx.lock();
+    while (true) {
+        // Releases the mutex while waiting, holds it again once woken
+        co_await queue_cv.wait(guard, [] {
+            return !work_queue.empty() || queue_closed;
+        });
+        if (work_queue.empty()) {
+            break;
+        }
+        std::cout << "  Consumed " << work_queue.back() << std::endl;
+        work_queue.pop_back();
+    }
+    std::cout << "  Queue closed" << std::endl;
+}
+
+pollcoro::task<> queue_producer() {
+    for (int i = 1; i <= 3; ++i) {
+        co_await pollcoro::yield();
+        auto guard = co_await queue_mtx.lock();
+        work_queue.push_back(i);
+        std::cout << "  Produced " << i << std::endl;
+        queue_cv.notify_one();
+    }
+    auto guard = co_await queue_mtx.lock();
+    queue_closed = true;
+    queue_cv.notify_all();
+}
+
+pollcoro::task<> test_condition_variable() {
+    std::cout << "=== condition_variable ===" << std::endl;
+    co_await pollcoro::wait_all(queue_consumer(), queue_producer());
+    std::cout << std::endl;
+}
+
 // =============================================================================
 // Main
 // =============================================================================
@@ -329,6 +403,8 @@ int main() {
     pollcoro::block_on(test_shared_mutex_try_lock());
     pollcoro::block_on(test_cache());
     pollcoro::block_on(test_fairness());
+    pollcoro::block_on(test_semaphore());
+    pollcoro::block_on(test_condition_variable());
 
     return 0;
 }
@@ -0,0 +1,80 @@
+/*
+ * Notify Example
+ *
+ * Demonstrates pollcoro::notify for repeated "something changed" signalling.
+ * Unlike single_event, a notify can be reused indefinitely without creating
+ * a new event for every signal.
+ */
+
+#include <coroutine>
+#include <deque>
+#include <iostream>
+
+import pollcoro;
+
+// =============================================================================
+// Example 1: Producer/consumer wakeups
+// =============================================================================
+
+pollcoro::notify data_ready;
+std::deque<int> queue;
+bool finished = false;
+
+pollcoro::task<> consumer() {
+    while (true) {
+        while (!queue.empty()) {
+            std::cout << "  Consumed " << queue.front() << std::endl;
+            queue.pop_front();
+        }
+        if (finished) {
+            co_return;
+        }
+        co_await data_ready.wait();
+    }
+}
+
+pollcoro::task<> producer() {
+    for (int i = 0; i < 5; ++i) {
+        queue.push_back(i);
+        // Wakes the consumer, or leaves a permit if it isn't waiting yet
+        data_ready.notify_one();
+        co_await pollcoro::yield();
+    }
+    finished = true;
+    data_ready.notify_one();
+}
+
+pollcoro::task<> test_notify_one() {
+    std::cout << "=== notify_one ===" << std::endl;
+    co_await pollcoro::wait_all(consumer(), producer());
+    std::cout << std::endl;
+}
+
+// =============================================================================
+// Example 2: Broadcasting to several waiters
+// =============================================================================
+
+pollcoro::notify start_signal;
+
+pollcoro::task<> worker(int id) {
+    co_await start_signal.wait();
+    std::cout << "  Worker " << id << " started" << std::endl;
+}
+
+pollcoro::task<> starter() {
+    co_await pollcoro::yield();
+    std::cout << "  Starting all workers" << std::endl;
+    start_signal.notify_all();
+}
+
+pollcoro::task<> test_notify_all() {
+    std::cout << "=== notify_all ===" << std::endl;
+    co_await pollcoro::wait_all(worker(1), worker(2), worker(3), starter());
+    std::cout << std::endl;
+}
+
+int main() {
+    pollcoro::block_on(test_notify_one());
+    pollcoro::block_on(test_notify_all());
+    return 0;
+}
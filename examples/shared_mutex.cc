@@ -0,0 +1,217 @@
+/*
+ * shared_mutex Example
+ *
+ * Exercises pollcoro::shared_mutex with readers, an upgradable holder and
+ * writers, first step by step and then concurrently from several threads.
+ *
+ * An upgradable lock is a shared lock that only one task holds at a time. It
+ * can be upgraded to an exclusive lock once the other readers have drained,
+ * without releasing it in between. An exclusive lock can likewise be
+ * downgraded to a shared one, admitting the readers queued behind it.
+ *
+ * The stress test checks that the lock's guarantees hold while tasks are
+ * polled from different threads, and that no waiter is left behind: every
+ * task has to be woken for the program to finish.
+ */
+
+#include <atomic>
+#include <coroutine>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+import pollcoro;
+
+// =============================================================================
+// Example 1: Downgrade admits queued readers
+// =============================================================================
+
+pollcoro::task<> queued_reader(pollcoro::shared_mutex& mtx, int id) {
+    auto guard = co_await mtx.lock_shared();
+    std::cout << "  Reader " << id << " admitted (" << mtx.reader_count() << " readers)"
+              << std::endl;
+    co_await pollcoro::yield();
+}
+
+pollcoro::task<> queued_writer(pollcoro::shared_mutex& mtx) {
+    auto guard = co_await mtx.lock();
+    std::cout << "  Writer admitted once every reader has left" << std::endl;
+}
+
+pollcoro::task<> test_downgrade() {
+    std::cout << "=== Downgrade with queued readers ===" << std::endl;
+
+    pollcoro::shared_mutex mtx;
+    auto writer = co_await mtx.lock();
+    std::cout << "Writer holds the lock" << std::endl;
+
+    // Queue two readers and a second writer behind the lock
+    auto r1 = queued_reader(mtx, 1);
+    auto r2 = queued_reader(mtx, 2);
+    auto w = queued_writer(mtx);
+    pollcoro::waker noop;
+    r1.poll(noop);
+    r2.poll(noop);
+    w.poll(noop);
+
+    // The readers are let in alongside the downgraded guard; the queued writer
+    // keeps waiting until all three shared locks are gone
+    auto reader = writer.downgrade();
+    std::cout << "Downgraded: " << mtx.reader_count() << " readers, writer active: "
+              << (mtx.is_writer_active() ? "yes" : "no") << std::endl;
+
+    co_await std::move(r1);
+    co_await std::move(r2);
+    reader.unlock();
+    co_await std::move(w);
+
+    std::cout << std::endl;
+}
+
+// =============================================================================
+// Example 2: Upgrade waits for the remaining readers to drain
+// =============================================================================
+
+pollcoro::task<> test_upgrade() {
+    std::cout << "=== Upgrade with readers draining ===" << std::endl;
+
+    pollcoro::shared_mutex mtx;
+    auto upgradable = co_await mtx.lock_upgradable();
+    auto reader = co_await mtx.lock_shared();
+    std::cout << "Upgradable holder and one reader: " << mtx.reader_count() << " readers"
+              << std::endl;
+
+    auto upgrade = upgradable.upgrade();
+    pollcoro::waker noop;
+    std::cout << "  Upgrade ready while the reader holds on: "
+              << (upgrade.poll(noop).is_ready() ? "yes" : "no") << std::endl;
+
+    // The pending upgrade holds back new readers
+    std::cout << "  New reader admitted: " << (mtx.try_lock_shared() ? "yes" : "no")
+              << std::endl;
+
+    reader.unlock();
+    auto writer = co_await std::move(upgrade);
+    std::cout << "  Upgraded after the reader left, writer active: "
+              << (mtx.is_writer_active() ? "yes" : "no") << std::endl;
+
+    std::cout << std::endl;
+}
+
+// =============================================================================
+// Example 3: Readers, an upgrader and writers from several threads
+// =============================================================================
+
+constexpr int threads = 4;
+constexpr int iterations = 2000;
+
+pollcoro::shared_mutex stress_mtx;
+std::atomic<int> readers_inside{0};
+std::atomic<int> upgraders_inside{0};
+std::atomic<int> writers_inside{0};
+std::atomic<int> violations{0};
+std::atomic<int> completed{0};
+
+void check(bool ok) {
+    if (!ok) {
+        violations.fetch_add(1);
+    }
+}
+
+pollcoro::task<> stress_reader() {
+    for (int i = 0; i < iterations; ++i) {
+        auto guard = co_await stress_mtx.lock_shared();
+        readers_inside.fetch_add(1);
+        check(writers_inside.load() == 0);
+        co_await pollcoro::yield();
+        readers_inside.fetch_sub(1);
+    }
+    completed.fetch_add(1);
+}
+
+pollcoro::task<> stress_upgrader() {
+    for (int i = 0; i < iterations; ++i) {
+        auto guard = co_await stress_mtx.lock_upgradable();
+        check(upgraders_inside.fetch_add(1) == 0);
+        check(writers_inside.load() == 0);
+        co_await pollcoro::yield();
+        upgraders_inside.fetch_sub(1);
+
+        if (i % 2 == 0) {
+            // Other readers may still hold the lock; the upgrade waits for them
+            auto writer = co_await guard.upgrade();
+            check(writers_inside.fetch_add(1) == 0);
+            check(readers_inside.load() == 0 && upgraders_inside.load() == 0);
+            co_await pollcoro::yield();
+            writers_inside.fetch_sub(1);
+        }
+    }
+    completed.fetch_add(1);
+}
+
+pollcoro::task<> stress_writer() {
+    for (int i = 0; i < iterations; ++i) {
+        auto writer = co_await stress_mtx.lock();
+        check(writers_inside.fetch_add(1) == 0);
+        check(readers_inside.load() == 0 && upgraders_inside.load() == 0);
+        co_await pollcoro::yield();
+        writers_inside.fetch_sub(1);
+
+        if (i % 2 == 0) {
+            // Keep reading what was just written, alongside any queued readers
+            auto reader = writer.downgrade();
+            readers_inside.fetch_add(1);
+            check(writers_inside.load() == 0);
+            co_await pollcoro::yield();
+            readers_inside.fetch_sub(1);
+        }
+    }
+    completed.fetch_add(1);
+}
+
+void test_stress() {
+    std::cout << "=== Concurrent readers, upgrader and writers ===" << std::endl;
+
+    // Every thread runs readers and a writer; the first also runs the upgrader
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([t] {
+            if (t == 0) {
+                pollcoro::block_on(
+                    pollcoro::wait_all(stress_reader(), stress_upgrader(), stress_writer())
+                );
+            } else {
+                pollcoro::block_on(
+                    pollcoro::wait_all(stress_reader(), stress_reader(), stress_writer())
+                );
+            }
+        });
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    std::cout << "Tasks completed: " << completed.load() << " (expected " << threads * 3 << ")"
+              << std::endl;
+    std::cout << "Exclusion violations: " << violations.load() << std::endl;
+    std::cout << "Lock free afterwards: "
+              << (stress_mtx.reader_count() == 0 && !stress_mtx.is_writer_active() ? "yes"
+                                                                                     : "no")
+              << std::endl;
+    std::cout << std::endl;
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main() {
+    std::cout << "pollcoro shared_mutex Examples" << std::endl;
+    std::cout << "==============================" << std::endl << std::endl;
+
+    pollcoro::block_on(test_downgrade());
+    pollcoro::block_on(test_upgrade());
+    test_stress();
+
+    return violations.load() == 0 && completed.load() == threads * 3 ? 0 : 1;
+}
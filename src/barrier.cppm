@@ -0,0 +1,265 @@
+module;
+
+#if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#endif
+
+export module pollcoro:barrier;
+
+#if defined(POLLCORO_IMPORT_STD) && POLLCORO_IMPORT_STD == 1
+import std;
+#endif
+
+import :awaitable;
+import :is_blocking;
+import :waiter_list;
+import :waker;
+
+export namespace pollcoro {
+
+template<typename CompletionFunction>
+class barrier;
+template<typename CompletionFunction>
+class barrier_awaitable;
+
+namespace detail {
+
+struct barrier_noop {
+    void operator()() const noexcept {}
+};
+
+struct barrier_waiter : waiter_node {
+    std::uint64_t phase_ = 0;
+};
+
+template<typename CompletionFunction>
+struct barrier_state {
+    mutable std::mutex mtx_;
+    waiter_list waiters_;
+    std::atomic<std::uint64_t> phase_{0};
+    std::ptrdiff_t expected_;
+    std::ptrdiff_t remaining_;
+    CompletionFunction completion_;
+
+    barrier_state(std::ptrdiff_t expected, CompletionFunction completion)
+        : expected_(expected), remaining_(expected), completion_(std::move(completion)) {}
+
+    bool has_completed(std::uint64_t phase) const noexcept {
+        return phase_.load(std::memory_order_acquire) != phase;
+    }
+
+    // Returns the phase the arrival belongs to. `drop` permanently lowers the
+    // number of arrivals expected in later phases.
+    std::uint64_t arrive(std::ptrdiff_t n, std::ptrdiff_t drop = 0) {
+        std::unique_lock lock(mtx_);
+        auto phase = phase_.load(std::memory_order_relaxed);
+        expected_ -= drop;
+        remaining_ -= n;
+        if (remaining_ == 0) {
+            complete_phase(lock, phase);
+        }
+        return phase;
+    }
+
+  private:
+    // Runs the completion function and starts the next phase. Must be called
+    // with `mtx_` held through `lock`, which it releases.
+    void complete_phase(std::unique_lock<std::mutex>& lock, std::uint64_t phase) {
+        std::invoke(completion_);
+        remaining_ = expected_;
+        phase_.store(phase + 1, std::memory_order_release);
+
+        // Waiters are queued in phase order. While the batch is flushed
+        // unlocked, tasks may already queue for the next phase, or even
+        // complete it and wake part of this one; stop at the first node that
+        // belongs to a later phase.
+        wake_batch batch;
+        while (auto node = static_cast<barrier_waiter*>(waiters_.front())) {
+            if (node->phase_ > phase) {
+                break;
+            }
+            if (batch.full()) {
+                lock.unlock();
+                batch.wake_all();
+                lock.lock();
+                continue;
+            }
+            waiters_.pop_front();
+            batch.push(node->waker_);
+        }
+        lock.unlock();
+        batch.wake_all();
+    }
+};
+
+}  // namespace detail
+
+/// Identifies the phase an arrival at a `barrier` belongs to. Returned by
+/// `barrier::arrive` and consumed by `barrier::wait`.
+class barrier_arrival_token {
+    std::uint64_t phase_;
+
+    template<typename>
+    friend class barrier;
+
+    explicit barrier_arrival_token(std::uint64_t phase) : phase_(phase) {}
+};
+
+/// Awaitable returned by `barrier::wait` and `barrier::arrive_and_wait`.
+/// Completes once the phase it waits on has completed, after the barrier's
+/// completion function has run.
+///
+/// For `arrive_and_wait`, the arrival is made when the awaitable is first
+/// polled.
+template<typename CompletionFunction>
+class barrier_awaitable : public awaitable_always_blocks {
+    detail::barrier_state<CompletionFunction>* state_;
+    std::uint64_t phase_;
+    bool arrive_;
+    detail::barrier_waiter node_;
+    bool registered_{false};
+
+    void deregister() {
+        if (registered_ && state_) {
+            std::lock_guard lock(state_->mtx_);
+            if (node_.linked_) {
+                state_->waiters_.remove(&node_);
+            }
+            registered_ = false;
+        }
+    }
+
+    friend class barrier<CompletionFunction>;
+
+    barrier_awaitable(
+        detail::barrier_state<CompletionFunction>* state, std::uint64_t phase, bool arrive
+    )
+        : state_(state), phase_(phase), arrive_(arrive) {}
+
+  public:
+    barrier_awaitable(barrier_awaitable&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)),
+          phase_(other.phase_),
+          arrive_(std::exchange(other.arrive_, false)),
+          registered_(std::exchange(other.registered_, false)) {
+        if (registered_) {
+            std::lock_guard lock(state_->mtx_);
+            if (other.node_.linked_) {
+                state_->waiters_.replace(&other.node_, &node_);
+            }
+            node_.waker_ = other.node_.waker_;
+            node_.phase_ = other.node_.phase_;
+        }
+    }
+
+    barrier_awaitable& operator=(barrier_awaitable&&) = delete;
+    barrier_awaitable(const barrier_awaitable&) = delete;
+    barrier_awaitable& operator=(const barrier_awaitable&) = delete;
+
+    ~barrier_awaitable() {
+        deregister();
+    }
+
+    awaitable_state<> poll(const waker& w) {
+        if (std::exchange(arrive_, false)) {
+            phase_ = state_->arrive(1);
+        }
+        if (state_->has_completed(phase_)) {
+            deregister();
+            return awaitable_state<>::ready();
+        }
+
+        std::lock_guard lock(state_->mtx_);
+        if (state_->has_completed(phase_)) {
+            if (node_.linked_) {
+                state_->waiters_.remove(&node_);
+            }
+            registered_ = false;
+            return awaitable_state<>::ready();
+        }
+        if (node_.linked_) {
+            detail::rearm_waker(node_.waker_, w);
+        } else {
+            node_.phase_ = phase_;
+            node_.waker_ = w;
+            state_->waiters_.push_back(&node_);
+            registered_ = true;
+        }
+        return awaitable_state<>::pending();
+    }
+};
+
+/// A reusable rendezvous point for a fixed group of tasks, the async
+/// counterpart of `std::barrier`.
+///
+/// Each phase completes once `expected` arrivals have been made. The last
+/// arrival runs `completion()` and then wakes every task waiting on that phase,
+/// and the barrier resets for the next phase. Waiters are linked intrusively
+/// through their awaitables and the barrier keeps only a phase counter, so no
+/// phase ever allocates.
+///
+/// The completion function runs while the barrier's internal lock is held. It
+/// must not throw and must not arrive at the same barrier.
+///
+/// Example:
+/// ```cpp
+/// pollcoro::barrier sync(workers, [&]() noexcept { swap(current, next); });
+///
+/// task<void> worker(std::size_t id) {
+///     for (int step = 0; step < steps; ++step) {
+///         compute(id, current, next);
+///         co_await sync.arrive_and_wait();
+///     }
+/// }
+/// ```
+template<typename CompletionFunction = detail::barrier_noop>
+class barrier {
+    static_assert(
+        std::is_nothrow_invocable_v<CompletionFunction&>,
+        "barrier completion function must be invocable without arguments and noexcept"
+    );
+
+    detail::barrier_state<CompletionFunction> state_;
+
+  public:
+    explicit barrier(std::ptrdiff_t expected, CompletionFunction completion = CompletionFunction())
+        : state_(expected, std::move(completion)) {}
+
+    barrier(const barrier&) = delete;
+    barrier& operator=(const barrier&) = delete;
+
+    /// Arrives at the current phase `n` times without waiting. Pass the
+    /// returned token to `wait()` to wait for that phase to complete.
+    [[nodiscard]] barrier_arrival_token arrive(std::ptrdiff_t n = 1) {
+        return barrier_arrival_token(state_.arrive(n));
+    }
+
+    /// Returns an awaitable that completes once the phase `token` was obtained
+    /// in has completed.
+    barrier_awaitable<CompletionFunction> wait(barrier_arrival_token&& token) {
+        return barrier_awaitable<CompletionFunction>(&state_, token.phase_, false);
+    }
+
+    /// Returns an awaitable that arrives at the current phase when first
+    /// polled, then waits for that phase to complete.
+    barrier_awaitable<CompletionFunction> arrive_and_wait() {
+        return barrier_awaitable<CompletionFunction>(&state_, 0, true);
+    }
+
+    /// Arrives at the current phase and lowers the number of arrivals expected
+    /// in every later phase by one.
+    void arrive_and_drop() {
+        state_.arrive(1, 1);
+    }
+};
+
+template<typename CompletionFunction>
+barrier(std::ptrdiff_t, CompletionFunction) -> barrier<CompletionFunction>;
+
+}  // namespace pollcoro
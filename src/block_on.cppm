@@ -1,6 +1,7 @@
 module;
 
 #if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #endif
@@ -12,49 +13,86 @@ import std;
 #endif
 
 import :awaitable;
+import :budget;
+import :instrument;
 import :is_blocking;
+import :trace;
 import :waker;
 
 export namespace pollcoro {
+
+namespace detail {
+
+// Waker target of `block_on`, recycled across calls because a wake may still
+// arrive after the awaitable it was registered with has completed.
+struct block_on_waker {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool notified = false;
+    [[no_unique_address]] wake_timestamp_t woken_at;  // For instrumentation
+
+    void wake() noexcept {
+        woken_at.record();
+        auto traced = trace_begin();
+        trace_flow_begin(this, traced);
+        {
+            std::lock_guard lock(mutex);
+            notified = true;
+            cv.notify_all();
+        }
+        trace_complete("block_on::wake", "wake", 0, traced);
+    }
+};
+
+}  // namespace detail
+
 template<awaitable Awaitable>
 auto block_on(Awaitable&& awaitable) -> awaitable_result_t<std::remove_cvref_t<Awaitable>> {
     if constexpr (!is_blocking_v<Awaitable>) {
         while (true) {
+            budget_scope budget;
+            auto traced = detail::trace_begin();
             auto result = awaitable.poll(waker());
+            detail::trace_complete("block_on::poll", "poll", 0, traced, result.is_ready());
+            if (auto hooks = detail::instrumentation_hooks()) {
+                hooks->on_block_on_poll(result.is_ready(), std::chrono::nanoseconds(-1));
+            }
             if (result.is_ready()) {
                 return result.take_result();
             }
         }
     }
 
-    struct waker_data_t {
-        std::mutex mutex;
-        std::condition_variable cv;
-        bool notified = false;
-
-        void wake() noexcept {
-            {
-                std::lock_guard lock(mutex);
-                notified = true;
-            }
-            cv.notify_all();
-        }
-    };
-
-    waker_data_t wd;
-    while (true) {
-        std::unique_lock lock(wd.mutex);
-        wd.notified = false;
+    detail::recycled_waker_target<detail::block_on_waker> wd;
+    for (bool woken = false;; woken = true) {
+        std::unique_lock lock(wd->mutex);
+        wd->notified = false;
         lock.unlock();
 
-        auto result = awaitable.poll(waker(wd));
-        if (result.is_ready()) {
-            return result.take_result();
+        {
+            budget_scope budget;
+            // The target's last wake may belong to a previous `block_on`
+            instrumentation_poll_scope instrumented(
+                woken ? wd->woken_at.get() : std::chrono::steady_clock::time_point{}
+            );
+            auto since_wake = detail::instrumented_since_wake();
+            auto traced = detail::trace_begin();
+            if (woken) {
+                detail::trace_flow_end(&*wd, traced);
+            }
+            auto result = awaitable.poll(waker(*wd));
+            detail::trace_complete("block_on::poll", "poll", 0, traced, result.is_ready());
+            if (auto hooks = detail::instrumentation_hooks()) {
+                hooks->on_block_on_poll(result.is_ready(), since_wake);
+            }
+            if (result.is_ready()) {
+                return result.take_result();
+            }
         }
 
         lock.lock();
-        wd.cv.wait(lock, [&] {
-            return wd.notified;
+        wd->cv.wait(lock, [&] {
+            return wd->notified;
         });
     }
 }
@@ -0,0 +1,88 @@
+module;
+
+#if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <cstddef>
+#include <utility>
+#endif
+
+export module pollcoro:budget;
+
+#if defined(POLLCORO_IMPORT_STD) && POLLCORO_IMPORT_STD == 1
+import std;
+#endif
+
+import :waker;
+
+export namespace pollcoro {
+
+/// Number of budget units an executor grants to each top-level poll.
+inline constexpr std::size_t default_poll_budget = 128;
+
+namespace detail {
+
+// Budget left in the poll currently running on this thread.
+inline thread_local std::size_t poll_budget = default_poll_budget;
+
+// Whether an executor has opened a `budget_scope` on this thread. Outside of
+// one, nothing refills the budget per poll, so it is refilled as it runs out.
+inline thread_local bool poll_budget_scoped = false;
+
+}  // namespace detail
+
+/// Grants a fresh cooperative budget to the poll running on this thread for as
+/// long as the scope is alive, restoring the previous budget afterwards.
+///
+/// Executors open one around every top-level poll. Awaitables that keep
+/// working while their inputs are ready, such as a task resuming through
+/// synchronous suspensions or `last()` draining a stream, spend one unit per
+/// step, so a single poll cannot monopolize the thread.
+class budget_scope {
+    std::size_t saved_;
+    bool saved_scoped_;
+
+  public:
+    explicit budget_scope(std::size_t budget = default_poll_budget) noexcept
+        : saved_(std::exchange(detail::poll_budget, budget)),
+          saved_scoped_(std::exchange(detail::poll_budget_scoped, true)) {}
+
+    budget_scope(const budget_scope&) = delete;
+    budget_scope& operator=(const budget_scope&) = delete;
+
+    ~budget_scope() {
+        detail::poll_budget = saved_;
+        detail::poll_budget_scoped = saved_scoped_;
+    }
+};
+
+/// Spends one unit of the current poll's budget after a step of work. Returns
+/// false once the budget is exhausted, after waking `w`; the caller should
+/// then return pending so the executor can run other tasks before polling it
+/// again. Outside any `budget_scope` the budget is refilled once exhausted, so
+/// a poll still takes at most `default_poll_budget` steps.
+///
+/// Example:
+/// ```cpp
+/// while (true) {
+///     auto state = stream_.poll_next(w);
+///     if (!state.is_ready()) {
+///         return ...;
+///     }
+///     process(state.take_result());
+///     if (!pollcoro::consume_budget(w)) {
+///         return state_type::pending();
+///     }
+/// }
+/// ```
+inline bool consume_budget(const waker& w) noexcept {
+    if (detail::poll_budget == 0) {
+        if (!detail::poll_budget_scoped) {
+            detail::poll_budget = default_poll_budget;
+        }
+        w.wake();
+        return false;
+    }
+    --detail::poll_budget;
+    return true;
+}
+
+}  // namespace pollcoro
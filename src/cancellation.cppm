@@ -0,0 +1,375 @@
+module;
+
+#if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#endif
+
+export module pollcoro:cancellation;
+
+#if defined(POLLCORO_IMPORT_STD) && POLLCORO_IMPORT_STD == 1
+import std;
+#endif
+
+import :awaitable;
+import :is_blocking;
+import :waiter_list;
+import :waker;
+
+export namespace pollcoro {
+
+class cancellation_token;
+class cancellation_registration;
+
+/// Thrown by cancellation-aware awaitables, such as `sleep_for`, when they are
+/// polled after cancellation of the surrounding operation has been requested.
+class operation_cancelled : public std::exception {
+  public:
+    const char* what() const noexcept override {
+        return "pollcoro::operation_cancelled";
+    }
+};
+
+namespace detail {
+
+struct cancellation_state {
+    std::atomic<bool> requested_{false};
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    waiter_list callbacks_;
+    waiter_node* running_ = nullptr;
+    std::thread::id running_thread_;
+
+    bool is_requested() const noexcept {
+        return requested_.load(std::memory_order_acquire);
+    }
+
+    // Wakes every registered waker, one at a time and without holding `mtx_`,
+    // so that a waker may poll the cancelled task inline. Returns false if
+    // cancellation had already been requested.
+    bool request() {
+        std::unique_lock lock(mtx_);
+        if (requested_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        requested_.store(true, std::memory_order_release);
+        running_thread_ = std::this_thread::get_id();
+        while (auto node = callbacks_.pop_front()) {
+            running_ = node;
+            auto w = node->waker_;
+            lock.unlock();
+            w.wake();
+            lock.lock();
+            running_ = nullptr;
+            cv_.notify_all();
+        }
+        return true;
+    }
+
+    // Returns false without linking `node` if cancellation was already
+    // requested.
+    bool add(waiter_node* node) {
+        std::lock_guard lock(mtx_);
+        if (requested_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        callbacks_.push_back(node);
+        return true;
+    }
+
+    // Unlinks `node`. If its waker is being invoked on another thread, waits
+    // for that to finish so the caller may free whatever the waker refers to.
+    void remove(waiter_node* node) {
+        std::unique_lock lock(mtx_);
+        if (node->linked_) {
+            callbacks_.remove(node);
+        } else if (running_ == node && running_thread_ != std::this_thread::get_id()) {
+            cv_.wait(lock, [&] {
+                return running_ != node;
+            });
+        }
+    }
+
+    void relink(waiter_node* from, waiter_node* to) {
+        std::unique_lock lock(mtx_);
+        if (from->linked_) {
+            callbacks_.replace(from, to);
+            to->waker_ = from->waker_;
+        } else if (running_ == from && running_thread_ != std::this_thread::get_id()) {
+            cv_.wait(lock, [&] {
+                return running_ != from;
+            });
+        }
+    }
+};
+
+class cancellation_link;
+
+}  // namespace detail
+
+/// A handle through which an operation observes whether it should stop.
+///
+/// Tokens are cheap to copy and share ownership of the underlying state with
+/// the `cancellation_source` that issued them. A default-constructed token
+/// can never be cancelled.
+class cancellation_token {
+    std::shared_ptr<detail::cancellation_state> state_;
+
+    friend class cancellation_source;
+    friend class cancellation_registration;
+    friend class detail::cancellation_link;
+
+    explicit cancellation_token(std::shared_ptr<detail::cancellation_state> state)
+        : state_(std::move(state)) {}
+
+  public:
+    cancellation_token() = default;
+
+    /// Returns true if cancellation may ever be requested through this token.
+    bool can_be_cancelled() const noexcept {
+        return state_ != nullptr;
+    }
+
+    /// Returns true once cancellation has been requested.
+    bool is_cancellation_requested() const noexcept {
+        return state_ && state_->is_requested();
+    }
+
+    /// Throws `operation_cancelled` if cancellation has been requested.
+    void throw_if_cancellation_requested() const {
+        if (is_cancellation_requested()) {
+            throw operation_cancelled();
+        }
+    }
+
+    friend bool operator==(const cancellation_token& a, const cancellation_token& b) noexcept {
+        return a.state_ == b.state_;
+    }
+};
+
+/// Issues `cancellation_token`s and requests cancellation through them.
+class cancellation_source {
+    std::shared_ptr<detail::cancellation_state> state_ =
+        std::make_shared<detail::cancellation_state>();
+
+  public:
+    cancellation_source() = default;
+
+    cancellation_token token() const noexcept {
+        return cancellation_token(state_);
+    }
+
+    /// Requests cancellation, waking every registered waker. Returns false if
+    /// cancellation had already been requested.
+    bool request_cancellation() {
+        return state_->request();
+    }
+
+    bool is_cancellation_requested() const noexcept {
+        return state_->is_requested();
+    }
+};
+
+/// Registers a waker to be woken when cancellation is requested through a
+/// token. Cancellation-aware awaitables keep one alongside their other waker
+/// registrations so that a cancelled task is polled promptly, rather than when
+/// the event it waits on finally happens.
+///
+/// If cancellation has already been requested, the waker is woken
+/// immediately. Deregistration, on `reset()` or destruction, waits for the
+/// waker to return if another thread is invoking it.
+class cancellation_registration {
+    std::shared_ptr<detail::cancellation_state> state_;
+    detail::waiter_node node_;
+
+  public:
+    cancellation_registration() = default;
+
+    cancellation_registration(const cancellation_token& token, const waker& w) {
+        reset(token, w);
+    }
+
+    cancellation_registration(cancellation_registration&& other) noexcept
+        : state_(std::move(other.state_)) {
+        if (state_) {
+            state_->relink(&other.node_, &node_);
+        }
+    }
+
+    cancellation_registration& operator=(cancellation_registration&& other) noexcept {
+        if (this != &other) {
+            reset();
+            state_ = std::move(other.state_);
+            if (state_) {
+                state_->relink(&other.node_, &node_);
+            }
+        }
+        return *this;
+    }
+
+    cancellation_registration(const cancellation_registration&) = delete;
+    cancellation_registration& operator=(const cancellation_registration&) = delete;
+
+    ~cancellation_registration() {
+        reset();
+    }
+
+    /// Registers `w` with `token`, replacing any previous registration. Only
+    /// the waker is updated if the token is unchanged.
+    void reset(const cancellation_token& token, const waker& w) {
+        if (state_ == token.state_) {
+            if (state_) {
+                std::lock_guard lock(state_->mtx_);
+                if (node_.linked_ && !node_.waker_.will_wake(w)) {
+                    node_.waker_ = w;
+                }
+            }
+            return;
+        }
+        reset();
+        if (!token.state_) {
+            return;
+        }
+        state_ = token.state_;
+        node_.waker_ = w;
+        if (!state_->add(&node_)) {
+            w.wake();
+        }
+    }
+
+    /// Removes the registration, if any.
+    void reset() {
+        if (state_) {
+            state_->remove(&node_);
+            state_ = nullptr;
+        }
+    }
+};
+
+namespace detail {
+
+// One level of cancellable operation in the tree of operations being polled,
+// such as a `wait_first` or a `with_cancellation`. Its state is only allocated
+// once some awaitable underneath asks for the token, and is then linked to
+// the enclosing level so that cancelling an outer operation cancels this one.
+class cancellation_link {
+    std::shared_ptr<cancellation_state> state_;
+    cancellation_registration parent_registration_;
+    cancellation_link* parent_ = nullptr;
+    bool inherit_ = true;
+
+    friend class cancellation_scope;
+
+    static void cancel(void* state) noexcept {
+        static_cast<cancellation_state*>(state)->request();
+    }
+
+  public:
+    cancellation_link() = default;
+
+    // A link for an explicitly supplied token, ignoring enclosing operations
+    explicit cancellation_link(cancellation_token token)
+        : state_(std::move(token.state_)), inherit_(false) {}
+
+    cancellation_link(cancellation_link&&) = default;
+    cancellation_link& operator=(cancellation_link&&) = delete;
+
+    // Must only be called while this link is installed by a `cancellation_scope`
+    cancellation_token token() {
+        if (!state_ && inherit_) {
+            state_ = std::make_shared<cancellation_state>();
+            if (parent_) {
+                parent_registration_.reset(
+                    parent_->token(), waker(state_.get(), &cancellation_link::cancel)
+                );
+            }
+        }
+        return cancellation_token(state_);
+    }
+
+    void request() {
+        if (state_ && inherit_) {
+            state_->request();
+        }
+    }
+};
+
+inline thread_local cancellation_link* current_cancellation_link = nullptr;
+
+// Makes `link` the innermost cancellable operation for the duration of a poll.
+class cancellation_scope {
+    cancellation_link* saved_;
+
+  public:
+    explicit cancellation_scope(cancellation_link& link) noexcept
+        : saved_(std::exchange(current_cancellation_link, &link)) {
+        link.parent_ = saved_;
+    }
+
+    cancellation_scope(const cancellation_scope&) = delete;
+    cancellation_scope& operator=(const cancellation_scope&) = delete;
+
+    ~cancellation_scope() {
+        current_cancellation_link = saved_;
+    }
+};
+
+}  // namespace detail
+
+/// Returns the token of the innermost cancellable operation that is currently
+/// being polled on this thread, or a token that can never be cancelled if
+/// there is none.
+///
+/// The token is ambient: tasks see the token of whatever awaits them, however
+/// deeply nested, without it being passed down explicitly. It is only
+/// meaningful while polling, so awaitables should fetch it in `poll()`.
+inline cancellation_token current_cancellation_token() {
+    if (auto link = detail::current_cancellation_link) {
+        return link->token();
+    }
+    return cancellation_token();
+}
+
+template<awaitable Awaitable>
+class with_cancellation_awaitable : public awaitable_maybe_blocks<Awaitable> {
+    Awaitable awaitable_;
+    detail::cancellation_link link_;
+
+  public:
+    with_cancellation_awaitable(Awaitable&& awaitable, cancellation_token token)
+        : awaitable_(std::move(awaitable)), link_(std::move(token)) {}
+
+    auto poll(const waker& w) {
+        detail::cancellation_scope scope(link_);
+        return awaitable_.poll(w);
+    }
+};
+
+/// Runs `awaitable` with `token` as its ambient cancellation token, in place
+/// of the token of whatever awaits it.
+///
+/// Example:
+/// ```cpp
+/// pollcoro::cancellation_source source;
+/// std::thread([&] { wait_for_ctrl_c(); source.request_cancellation(); }).detach();
+///
+/// try {
+///     pollcoro::block_on(pollcoro::with_cancellation(serve(), source.token()));
+/// } catch (const pollcoro::operation_cancelled&) {
+///     // a timer inside serve() observed the request
+/// }
+/// ```
+template<awaitable Awaitable>
+auto with_cancellation(Awaitable&& awaitable, cancellation_token token) {
+    return with_cancellation_awaitable<std::remove_cvref_t<Awaitable>>(
+        std::move(awaitable), std::move(token)
+    );
+}
+
+}  // namespace pollcoro
@@ -0,0 +1,557 @@
+module;
+
+#if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <utility>
+#endif
+
+export module pollcoro:channel;
+
+#if defined(POLLCORO_IMPORT_STD) && POLLCORO_IMPORT_STD == 1
+import std;
+#endif
+
+import :awaitable;
+import :is_blocking;
+import :stream_awaitable;
+import :waiter_list;
+import :waker;
+
+export namespace pollcoro {
+
+template<typename T>
+class channel_sender;
+template<typename T>
+class channel_receiver;
+template<typename T>
+class channel_send_awaitable;
+
+namespace detail {
+
+/// Bounded lock-free MPMC ring buffer (Vyukov). Each slot carries a sequence
+/// number that tells producers and consumers whose turn it is, so neither side
+/// ever needs a lock.
+template<typename T>
+class bounded_ring {
+    struct slot {
+        std::atomic<std::size_t> sequence_;
+        std::optional<T> value_;
+    };
+
+    std::unique_ptr<slot[]> slots_;
+    std::size_t mask_;
+    alignas(cache_line_size) std::atomic<std::size_t> head_{0};
+    alignas(cache_line_size) std::atomic<std::size_t> tail_{0};
+
+  public:
+    explicit bounded_ring(std::size_t capacity)
+        : slots_(std::make_unique<slot[]>(std::bit_ceil(capacity == 0 ? 1 : capacity))),
+          mask_(std::bit_ceil(capacity == 0 ? 1 : capacity) - 1) {
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            slots_[i].sequence_.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    std::size_t capacity() const noexcept {
+        return mask_ + 1;
+    }
+
+    /// Moves from `value` only if a slot was available.
+    bool try_push(T& value) {
+        auto pos = tail_.load(std::memory_order_relaxed);
+        slot* s;
+        while (true) {
+            s = &slots_[pos & mask_];
+            auto seq = s->sequence_.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        s->value_.emplace(std::move(value));
+        s->sequence_.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<T> try_pop() {
+        auto pos = head_.load(std::memory_order_relaxed);
+        slot* s;
+        while (true) {
+            s = &slots_[pos & mask_];
+            auto seq = s->sequence_.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return std::nullopt;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        auto result = std::move(s->value_);
+        s->value_.reset();
+        s->sequence_.store(pos + mask_ + 1, std::memory_order_release);
+        return result;
+    }
+};
+
+struct channel_waiter : waiter_node {
+    bool notified_{false};
+};
+
+template<typename T>
+struct channel_state {
+    bounded_ring<T> buffer_;
+    std::atomic<std::size_t> senders_{1};
+    std::atomic<std::size_t> receivers_{1};
+
+    // Waiter bookkeeping is only touched on the slow path. The atomic counts
+    // mirror the list sizes so that the fast path can skip the lock entirely
+    // when nobody is waiting.
+    std::mutex mtx_;
+    waiter_list send_waiters_;
+    waiter_list recv_waiters_;
+    std::atomic<std::size_t> send_waiting_{0};
+    std::atomic<std::size_t> recv_waiting_{0};
+
+    explicit channel_state(std::size_t capacity) : buffer_(capacity) {}
+
+    void notify_receivers(std::size_t n = 1) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (recv_waiting_.load(std::memory_order_relaxed) != 0) {
+            wake(recv_waiters_, recv_waiting_, n);
+        }
+    }
+
+    void notify_senders(std::size_t n = 1) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (send_waiting_.load(std::memory_order_relaxed) != 0) {
+            wake(send_waiters_, send_waiting_, n);
+        }
+    }
+
+    void close_receivers() {
+        wake(recv_waiters_, recv_waiting_, std::numeric_limits<std::size_t>::max());
+    }
+
+    void close_senders() {
+        wake(send_waiters_, send_waiting_, std::numeric_limits<std::size_t>::max());
+    }
+
+    // Links `node` (if it isn't already) and refreshes its waker. Callers must
+    // re-check the buffer afterwards to avoid missing a concurrent wakeup.
+    void register_waiter(
+        waiter_list& list, std::atomic<std::size_t>& count, channel_waiter& node, const waker& w
+    ) {
+        {
+            std::lock_guard lock(mtx_);
+            if (node.linked_) {
+                detail::rearm_waker(node.waker_, w);
+            } else {
+                node.waker_ = w;
+                node.notified_ = false;
+                list.push_back(&node);
+                count.store(list.size(), std::memory_order_relaxed);
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    // Unlinks `node`. Returns true if it had been notified but never consumed
+    // that notification, in which case the caller should pass it on. A caller
+    // that just used the slot or item it was woken for passes `consumed`, so
+    // that its wake is not handed on to a waiter that would find nothing.
+    bool deregister_waiter(
+        waiter_list& list, std::atomic<std::size_t>& count, channel_waiter& node, bool consumed
+    ) {
+        std::lock_guard lock(mtx_);
+        if (node.linked_) {
+            list.remove(&node);
+            count.store(list.size(), std::memory_order_relaxed);
+            return false;
+        }
+        return std::exchange(node.notified_, false) && !consumed;
+    }
+
+    void relink_waiter(waiter_list& list, channel_waiter& from, channel_waiter& to) {
+        std::lock_guard lock(mtx_);
+        if (from.linked_) {
+            list.replace(&from, &to);
+        }
+        to.waker_ = from.waker_;
+        to.notified_ = std::exchange(from.notified_, false);
+    }
+
+  private:
+    // Wakes up to `n` waiters from `list`. The wakers are invoked once `mtx_`
+    // has been released, flushing the batch whenever it fills up.
+    bool wake(waiter_list& list, std::atomic<std::size_t>& count, std::size_t n) {
+        std::unique_lock lock(mtx_);
+        wake_batch batch;
+        bool woke = false;
+        for (; n > 0; --n) {
+            if (batch.full()) {
+                count.store(list.size(), std::memory_order_relaxed);
+                lock.unlock();
+                batch.wake_all();
+                lock.lock();
+            }
+            auto node = static_cast<channel_waiter*>(list.pop_front());
+            if (!node) {
+                break;
+            }
+            node->notified_ = true;
+            batch.push(node->waker_);
+            woke = true;
+        }
+        count.store(list.size(), std::memory_order_relaxed);
+        lock.unlock();
+        batch.wake_all();
+        return woke;
+    }
+};
+
+}  // namespace detail
+
+/// Awaitable returned by `channel_sender::send`. Resolves to `true` once the
+/// value has been placed in the channel, or `false` if every receiver has been
+/// dropped (the value is discarded in that case).
+template<typename T>
+class channel_send_awaitable : public awaitable_always_blocks {
+    detail::channel_state<T>* state_;
+    std::optional<T> value_;
+    detail::channel_waiter node_;
+    bool registered_{false};
+
+    using state_type = awaitable_state<bool>;
+
+    void deregister(bool consumed = false) {
+        if (registered_ && state_) {
+            registered_ = false;
+            if (state_->deregister_waiter(
+                    state_->send_waiters_, state_->send_waiting_, node_, consumed
+                )) {
+                state_->notify_senders();
+            }
+        }
+    }
+
+    friend class channel_sender<T>;
+
+    channel_send_awaitable(detail::channel_state<T>* state, T value)
+        : state_(state), value_(std::move(value)) {}
+
+  public:
+    channel_send_awaitable(channel_send_awaitable&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)),
+          value_(std::move(other.value_)),
+          registered_(std::exchange(other.registered_, false)) {
+        if (registered_) {
+            state_->relink_waiter(state_->send_waiters_, other.node_, node_);
+        }
+    }
+
+    channel_send_awaitable& operator=(channel_send_awaitable&&) = delete;
+    channel_send_awaitable(const channel_send_awaitable&) = delete;
+    channel_send_awaitable& operator=(const channel_send_awaitable&) = delete;
+
+    ~channel_send_awaitable() {
+        deregister();
+    }
+
+    state_type poll(const waker& w) {
+        if (state_->receivers_.load(std::memory_order_acquire) == 0) {
+            deregister();
+            return state_type::ready(false);
+        }
+
+        if (state_->buffer_.try_push(*value_)) {
+            deregister(true);
+            state_->notify_receivers();
+            return state_type::ready(true);
+        }
+
+        state_->register_waiter(state_->send_waiters_, state_->send_waiting_, node_, w);
+        registered_ = true;
+
+        // Re-check now that we are visible to receivers
+        if (state_->buffer_.try_push(*value_)) {
+            deregister(true);
+            state_->notify_receivers();
+            return state_type::ready(true);
+        }
+        if (state_->receivers_.load(std::memory_order_acquire) == 0) {
+            deregister();
+            return state_type::ready(false);
+        }
+        return state_type::pending();
+    }
+};
+
+/// Sending half of a channel. Copyable; every copy counts as a separate
+/// producer and the channel is closed once the last one is dropped.
+template<typename T>
+class channel_sender {
+    std::shared_ptr<detail::channel_state<T>> state_;
+
+    explicit channel_sender(std::shared_ptr<detail::channel_state<T>> state)
+        : state_(std::move(state)) {}
+
+    void reset() {
+        if (state_ && state_->senders_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            state_->close_receivers();
+        }
+        state_ = nullptr;
+    }
+
+    template<typename U>
+    friend std::tuple<channel_sender<U>, channel_receiver<U>> channel(std::size_t capacity);
+
+  public:
+    channel_sender(const channel_sender& other) : state_(other.state_) {
+        if (state_) {
+            state_->senders_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    channel_sender& operator=(const channel_sender& other) {
+        if (this != &other) {
+            reset();
+            state_ = other.state_;
+            if (state_) {
+                state_->senders_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        return *this;
+    }
+
+    channel_sender(channel_sender&& other) noexcept = default;
+
+    channel_sender& operator=(channel_sender&& other) noexcept {
+        if (this != &other) {
+            reset();
+            state_ = std::move(other.state_);
+        }
+        return *this;
+    }
+
+    ~channel_sender() {
+        reset();
+    }
+
+    /// Returns an awaitable that places `value` in the channel, waiting for
+    /// space if the channel is full. The sender must outlive the awaitable.
+    channel_send_awaitable<T> send(T value) {
+        return channel_send_awaitable<T>(state_.get(), std::move(value));
+    }
+
+    /// Attempts to place `value` in the channel without waiting. On failure
+    /// (channel full or no receivers left) `value` is left untouched.
+    bool try_send(T&& value) {
+        if (state_->receivers_.load(std::memory_order_acquire) == 0) {
+            return false;
+        }
+        if (!state_->buffer_.try_push(value)) {
+            return false;
+        }
+        state_->notify_receivers();
+        return true;
+    }
+
+    /// Returns true once every receiver has been dropped.
+    bool is_closed() const {
+        return state_->receivers_.load(std::memory_order_acquire) == 0;
+    }
+
+    std::size_t capacity() const {
+        return state_->buffer_.capacity();
+    }
+};
+
+/// Receiving half of a channel. A receiver is a stream that yields values in
+/// the order they were sent and finishes once every sender has been dropped and
+/// the buffer is drained. Copyable for multi-consumer use; each value is
+/// delivered to exactly one receiver.
+template<typename T>
+class channel_receiver : public awaitable_always_blocks {
+    std::shared_ptr<detail::channel_state<T>> state_;
+    detail::channel_waiter node_;
+    bool registered_{false};
+
+    using state_type = stream_awaitable_state<T>;
+
+    explicit channel_receiver(std::shared_ptr<detail::channel_state<T>> state)
+        : state_(std::move(state)) {}
+
+    void deregister(bool consumed = false) {
+        if (registered_ && state_) {
+            registered_ = false;
+            if (state_->deregister_waiter(
+                    state_->recv_waiters_, state_->recv_waiting_, node_, consumed
+                )) {
+                state_->notify_receivers();
+            }
+        }
+    }
+
+    void reset() {
+        if (state_) {
+            deregister();
+            if (state_->receivers_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                state_->close_senders();
+            }
+        }
+        state_ = nullptr;
+    }
+
+    template<typename U>
+    friend std::tuple<channel_sender<U>, channel_receiver<U>> channel(std::size_t capacity);
+
+  public:
+    channel_receiver(const channel_receiver& other) : state_(other.state_) {
+        if (state_) {
+            state_->receivers_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    channel_receiver& operator=(const channel_receiver& other) {
+        if (this != &other) {
+            reset();
+            state_ = other.state_;
+            if (state_) {
+                state_->receivers_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        return *this;
+    }
+
+    channel_receiver(channel_receiver&& other) noexcept
+        : state_(std::move(other.state_)), registered_(std::exchange(other.registered_, false)) {
+        if (registered_) {
+            state_->relink_waiter(state_->recv_waiters_, other.node_, node_);
+        }
+    }
+
+    channel_receiver& operator=(channel_receiver&& other) noexcept {
+        if (this != &other) {
+            reset();
+            state_ = std::move(other.state_);
+            registered_ = std::exchange(other.registered_, false);
+            if (registered_) {
+                state_->relink_waiter(state_->recv_waiters_, other.node_, node_);
+            }
+        }
+        return *this;
+    }
+
+    ~channel_receiver() {
+        reset();
+    }
+
+    state_type poll_next(const waker& w) {
+        if (auto value = try_recv()) {
+            deregister(true);
+            return state_type::ready(std::move(*value));
+        }
+
+        state_->register_waiter(state_->recv_waiters_, state_->recv_waiting_, node_, w);
+        registered_ = true;
+
+        // Re-check now that we are visible to senders
+        if (auto value = try_recv()) {
+            deregister(true);
+            return state_type::ready(std::move(*value));
+        }
+        if (state_->senders_.load(std::memory_order_acquire) == 0) {
+            deregister();
+            // A sender may have pushed right before dropping
+            if (auto value = try_recv()) {
+                return state_type::ready(std::move(*value));
+            }
+            return state_type::done();
+        }
+        return state_type::pending();
+    }
+
+    /// Takes a single value from the channel without waiting.
+    std::optional<T> try_recv() {
+        auto value = state_->buffer_.try_pop();
+        if (value) {
+            state_->notify_senders();
+        }
+        return value;
+    }
+
+    /// Takes up to `max` values from the channel without waiting, writing them
+    /// to `out`. Blocked senders are woken once for the whole batch. Returns the
+    /// number of values received.
+    template<typename OutputIt>
+    std::size_t try_recv_many(OutputIt out, std::size_t max) {
+        std::size_t count = 0;
+        while (count < max) {
+            auto value = state_->buffer_.try_pop();
+            if (!value) {
+                break;
+            }
+            *out++ = std::move(*value);
+            ++count;
+        }
+        if (count > 0) {
+            state_->notify_senders(count);
+        }
+        return count;
+    }
+
+    /// Returns true once every sender has been dropped. Values may still be
+    /// buffered.
+    bool is_closed() const {
+        return state_->senders_.load(std::memory_order_acquire) == 0;
+    }
+
+    std::size_t capacity() const {
+        return state_->buffer_.capacity();
+    }
+};
+
+/// Creates a bounded multi-producer multi-consumer channel. `capacity` is
+/// rounded up to the next power of two. Senders wait when the buffer is full,
+/// giving producers backpressure; the receiver is a stream that can be fed
+/// straight into combinators.
+///
+/// Example:
+/// ```cpp
+/// auto [tx, rx] = pollcoro::channel<int>(1024);
+///
+/// std::thread producer([tx = std::move(tx)]() mutable {
+///     for (int i = 0; i < 100; ++i) {
+///         pollcoro::block_on(tx.send(i));
+///     }
+/// });
+///
+/// int sum = pollcoro::block_on(pollcoro::fold(std::move(rx), 0, [](int& acc, int v) {
+///     acc += v;
+/// }));
+/// ```
+template<typename T>
+std::tuple<channel_sender<T>, channel_receiver<T>> channel(std::size_t capacity) {
+    auto state = std::make_shared<detail::channel_state<T>>(capacity);
+    return std::make_tuple(channel_sender<T>(state), channel_receiver<T>(state));
+}
+
+}  // namespace pollcoro
@@ -0,0 +1,245 @@
+module;
+
+#if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <utility>
+#endif
+
+export module pollcoro:condition_variable;
+
+#if defined(POLLCORO_IMPORT_STD) && POLLCORO_IMPORT_STD == 1
+import std;
+#endif
+
+import :awaitable;
+import :is_blocking;
+import :mutex;
+import :notify;
+import :waiter_list;
+import :waker;
+
+export namespace pollcoro {
+
+class condition_variable;
+
+namespace detail {
+
+struct condition_variable_state {
+    mutable std::mutex mtx_;
+    waiter_list waiters_;
+
+    void notify_one() {
+        std::unique_lock lock(mtx_);
+        notify_one_locked(lock);
+    }
+
+    // Wakes the waiters present when called. A waiter that re-registers while
+    // the batch is being flushed may be woken as well, which is harmless since
+    // condition variable waits recheck their predicate.
+    void notify_all() {
+        std::unique_lock lock(mtx_);
+        wake_batch batch;
+        for (auto n = waiters_.size(); n > 0 && !waiters_.empty(); --n) {
+            if (batch.full()) {
+                lock.unlock();
+                batch.wake_all();
+                lock.lock();
+            }
+            auto node = static_cast<notify_waiter*>(waiters_.pop_front());
+            node->notified_ = notification::all;
+            batch.push(node->waker_);
+        }
+        lock.unlock();
+        batch.wake_all();
+    }
+
+    // Must be called with `mtx_` held through `lock`, which it releases.
+    void notify_one_locked(std::unique_lock<std::mutex>& lock) {
+        auto node = static_cast<notify_waiter*>(waiters_.pop_front());
+        if (!node) {
+            return;
+        }
+        node->notified_ = notification::one;
+        auto w = node->waker_;
+        lock.unlock();
+        w.wake();
+    }
+};
+
+}  // namespace detail
+
+/// Awaitable returned by `condition_variable::wait`. Completes once the
+/// predicate holds, with the mutex held through the caller's guard.
+///
+/// While the predicate is false the mutex is released and the task sleeps
+/// until notified, then re-acquires the mutex and checks again. If the
+/// awaitable is dropped while waiting, the guard is left unlocked.
+template<typename Predicate>
+class condition_variable_awaitable : public awaitable_always_blocks {
+    detail::condition_variable_state* state_;
+    mutex_guard* guard_;
+    detail::mutex_state* mutex_;
+    Predicate predicate_;
+    detail::notify_waiter node_;
+    bool registered_{false};
+    std::optional<mutex_lock_awaitable> relock_;
+
+    void deregister() {
+        if (registered_ && state_) {
+            std::unique_lock lock(state_->mtx_);
+            registered_ = false;
+            if (node_.linked_) {
+                state_->waiters_.remove(&node_);
+            } else if (node_.notified_ == detail::notification::one) {
+                // Dropped before acting on a `notify_one`; pass it on so the
+                // notification is not lost.
+                state_->notify_one_locked(lock);
+            }
+        }
+    }
+
+    friend class condition_variable;
+
+    condition_variable_awaitable(
+        detail::condition_variable_state* state, mutex_guard& guard, Predicate predicate
+    )
+        : state_(state),
+          guard_(&guard),
+          mutex_(guard.state_),
+          predicate_(std::move(predicate)) {}
+
+  public:
+    condition_variable_awaitable(condition_variable_awaitable&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)),
+          guard_(other.guard_),
+          mutex_(other.mutex_),
+          predicate_(std::move(other.predicate_)),
+          registered_(std::exchange(other.registered_, false)),
+          relock_(std::move(other.relock_)) {
+        if (registered_) {
+            std::lock_guard lock(state_->mtx_);
+            if (other.node_.linked_) {
+                state_->waiters_.replace(&other.node_, &node_);
+            }
+            node_.waker_ = other.node_.waker_;
+            node_.notified_ = other.node_.notified_;
+        }
+        other.relock_.reset();
+    }
+
+    condition_variable_awaitable& operator=(condition_variable_awaitable&&) = delete;
+    condition_variable_awaitable(const condition_variable_awaitable&) = delete;
+    condition_variable_awaitable& operator=(const condition_variable_awaitable&) = delete;
+
+    ~condition_variable_awaitable() {
+        deregister();
+    }
+
+    awaitable_state<> poll(const waker& w) {
+        if (registered_) {
+            std::lock_guard lock(state_->mtx_);
+            if (node_.linked_) {
+                detail::rearm_waker(node_.waker_, w);
+                return awaitable_state<>::pending();
+            }
+            registered_ = false;
+            relock_.emplace(mutex_);
+        }
+
+        if (relock_) {
+            auto result = relock_->poll(w);
+            if (!result.is_ready()) {
+                return awaitable_state<>::pending();
+            }
+            *guard_ = result.take_result();
+            relock_.reset();
+        }
+
+        if (std::invoke(predicate_)) {
+            return awaitable_state<>::ready();
+        }
+
+        // Register before unlocking, so a notification sent by whoever takes
+        // the mutex next cannot be missed
+        {
+            std::lock_guard lock(state_->mtx_);
+            node_.waker_ = w;
+            node_.notified_ = detail::notification::none;
+            state_->waiters_.push_back(&node_);
+            registered_ = true;
+        }
+        guard_->unlock();
+        return awaitable_state<>::pending();
+    }
+};
+
+/// An async condition variable for use with `pollcoro::mutex`.
+///
+/// `wait(guard, predicate)` atomically releases the mutex held by `guard` and
+/// suspends the task until it is notified, then re-acquires the mutex and
+/// rechecks the predicate. Waiting tasks are linked intrusively and consume no
+/// CPU until signalled. As with `std::condition_variable`, notifications are
+/// not stored: a `notify_one()` with nobody waiting is lost, so always wait
+/// with a predicate that reflects the shared state.
+///
+/// Example:
+/// ```cpp
+/// pollcoro::mutex mtx;
+/// pollcoro::condition_variable cv;
+/// std::deque<job> jobs;
+///
+/// task<void> worker() {
+///     auto guard = co_await mtx.lock();
+///     co_await cv.wait(guard, [&] { return !jobs.empty(); });
+///     auto next = std::move(jobs.front());
+///     jobs.pop_front();
+/// }
+///
+/// task<void> submit(job j) {
+///     auto guard = co_await mtx.lock();
+///     jobs.push_back(std::move(j));
+///     cv.notify_one();
+/// }
+/// ```
+class condition_variable {
+    detail::condition_variable_state state_;
+
+  public:
+    condition_variable() = default;
+
+    condition_variable(const condition_variable&) = delete;
+    condition_variable& operator=(const condition_variable&) = delete;
+
+    /// Returns an awaitable that waits until `predicate()` returns true. The
+    /// predicate is only evaluated with the mutex held. `guard` must hold the
+    /// lock when the awaitable is first polled, and holds it again on
+    /// completion.
+    template<typename Predicate>
+    condition_variable_awaitable<Predicate> wait(mutex_guard& guard, Predicate predicate) {
+        return condition_variable_awaitable<Predicate>(&state_, guard, std::move(predicate));
+    }
+
+    /// Returns an awaitable that releases the mutex, waits for a single
+    /// notification and re-acquires it. Prefer the predicate overload, since
+    /// this one cannot tell which condition it was woken for.
+    auto wait(mutex_guard& guard) {
+        return wait(guard, [waited = false]() mutable {
+            return std::exchange(waited, true);
+        });
+    }
+
+    /// Wakes the oldest waiting task, if any.
+    void notify_one() {
+        state_.notify_one();
+    }
+
+    /// Wakes every task currently waiting.
+    void notify_all() {
+        state_.notify_all();
+    }
+};
+
+}  // namespace pollcoro
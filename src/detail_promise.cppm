@@ -1,10 +1,13 @@
 module;
 
 #if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <concepts>
 #include <coroutine>
+#include <cstdint>
 #include <cstdio>
 #include <exception>
 #include <optional>
+#include <source_location>
 #include <type_traits>
 #include <utility>
 #endif
@@ -17,7 +20,10 @@ import std;
 
 import :allocator;
 import :awaitable;
+import :instrument;
 import :stream_awaitable;
+import :task_registry;
+import :trace;
 import :waker;
 
 export namespace pollcoro::detail {
@@ -26,6 +32,94 @@ struct promise_base {
 
     void* current_awaitable = nullptr;
     bool (*current_awaitable_poll)(void*, const waker&) = nullptr;
+
+    // A `task` awaited directly by another coroutine is fused into it: the
+    // awaiting frame links the child instead of polling it, and only the
+    // frame being polled from outside (the root) drives the chain.
+    std::coroutine_handle<> handle_;
+    promise_base* parent_ = nullptr;  // Frame awaiting this one, while fused
+    promise_base* child_ = nullptr;   // Fused task this frame is awaiting
+    promise_base* leaf_ = nullptr;    // Innermost frame, cached on the root
+
+    [[no_unique_address]] frame_record_t record_;  // For `dump_tasks()`
+    [[no_unique_address]] trace_span trace_;       // Frame lifetime, for tracing
+
+    bool poll_current(const waker& w) {
+        if (current_awaitable_poll) {
+            return current_awaitable_poll(current_awaitable, w);
+        }
+        return true;
+    }
+
+    // Polls the innermost frame of the fused chain rooted here, then resumes
+    // frames for as long as what they await is ready, handing each finished
+    // child's result straight to its parent. Only the leaf is polled, so the
+    // cost does not grow with the depth of nested `co_await`s. Returns true if
+    // any frame was resumed.
+    bool poll_ready(const waker& w) {
+        note_frame_polled(record_);
+        auto leaf = leaf_ ? leaf_ : this;
+        while (leaf->child_) {
+            leaf = leaf->child_;
+        }
+
+        bool ready;
+        set_frame_state(leaf->record_, frame_state::running);
+        try {
+            frame_poll_scope scope(leaf->record_);
+            ready = leaf->poll_current(w);
+        } catch (...) {
+            leaf->exception = std::current_exception();
+            ready = true;
+        }
+        detail::instrument_poll(leaf->handle_.address(), poll_site::frame, ready);
+        if (!ready) {
+            set_frame_state(leaf->record_, frame_state::suspended);
+            leaf_ = leaf;
+            return false;
+        }
+
+        leaf->resume();
+        while (leaf != this && leaf->handle_.done()) {
+            leaf = leaf->parent_;
+            leaf->resume();
+        }
+        leaf_ = leaf;
+        return true;
+    }
+
+    // Records a poll of this frame by its `task` or `stream`, named after the
+    // coroutine, or `what` if the frame predates the trace.
+    void trace_poll(const char* what, std::int64_t started, bool ready) noexcept {
+        trace_complete(trace_.name(what), "poll", trace_.id(), started, ready);
+    }
+
+  private:
+    void resume() {
+        set_frame_state(record_, frame_state::running);
+        handle_.resume();
+        if (!handle_.done()) {
+            set_frame_state(record_, frame_state::suspended);
+        }
+    }
+};
+
+// Grants `transform_awaitable` access to the coroutine owned by a task, so it
+// can be fused into the awaiting coroutine.
+struct task_access {
+    template<typename Task>
+    static auto handle(Task& task) noexcept -> decltype(task.handle_) {
+        return task.handle_;
+    }
+};
+
+template<typename Awaitable>
+concept fusable_task = awaitable<Awaitable> && requires(Awaitable& awaitable) {
+    typename Awaitable::promise_type;
+    requires std::derived_from<typename Awaitable::promise_type, promise_base>;
+    {
+        task_access::handle(awaitable)
+    } -> std::same_as<std::coroutine_handle<typename Awaitable::promise_type>>;
 };
 
 template<typename T>
@@ -68,6 +162,7 @@ class stream_storage : public promise_base {
             }
 
             void await_suspend(std::coroutine_handle<>) {
+                set_frame_awaiting<StreamAwaitable>(promise.record_);
                 promise.exception = nullptr;
                 promise.current_awaitable = this;
                 promise.current_awaitable_poll = [](void* awaitable, const waker& w) {
@@ -85,6 +180,7 @@ class stream_storage : public promise_base {
             }
 
             void await_resume() {
+                clear_frame_awaiting(promise.record_);
                 auto exception = promise.exception;
                 promise.current_awaitable = nullptr;
                 promise.current_awaitable_poll = nullptr;
@@ -112,6 +208,48 @@ class stream_storage : public promise_base {
     }
 };
 
+template<typename promise_type, fusable_task Task>
+auto transform_awaitable(promise_type& promise, Task&& task) {
+    using result_type = awaitable_result_t<Task>;
+
+    // Links the child's frame below the awaiting one. The root resumes this
+    // coroutine once the child has finished, so the result is taken directly
+    // from the child's promise. A child that has already finished is not
+    // linked: the root would resume its completed frame.
+    struct fused_task {
+        promise_type& promise;
+        Task task;
+
+        bool await_ready() {
+            return task_access::handle(task).done();
+        }
+
+        void await_suspend(std::coroutine_handle<>) {
+            auto& child = task_access::handle(task).promise();
+            set_frame_awaiting<Task>(promise.record_);
+            set_frame_parent(child.record_, &promise.record_);
+            promise.exception = nullptr;
+            promise.child_ = &child;
+            child.parent_ = &promise;
+        }
+
+        result_type await_resume() {
+            auto& child = task_access::handle(task).promise();
+            clear_frame_awaiting(promise.record_);
+            promise.child_ = nullptr;
+            child.parent_ = nullptr;
+            if (auto exception = std::exchange(child.exception, nullptr)) {
+                std::rethrow_exception(exception);
+            }
+            if constexpr (!std::is_void_v<result_type>) {
+                return child.take_result();
+            }
+        }
+    };
+
+    return fused_task{promise, std::move(task)};
+}
+
 template<typename promise_type, awaitable Awaitable>
 auto transform_awaitable(promise_type& promise, Awaitable&& awaitable) {
     using result_type = awaitable_result_t<Awaitable>;
@@ -125,6 +263,7 @@ auto transform_awaitable(promise_type& promise, Awaitable&& awaitable) {
         }
 
         void await_suspend(std::coroutine_handle<>) {
+            set_frame_awaiting<Awaitable>(promise.record_);
             promise.exception = nullptr;
             promise.current_awaitable = this;
             promise.current_awaitable_poll = [](void* awaitable, const waker& w) {
@@ -142,6 +281,7 @@ auto transform_awaitable(promise_type& promise, Awaitable&& awaitable) {
         }
 
         result_type await_resume() {
+            clear_frame_awaiting(promise.record_);
             auto exception = promise.exception;
             promise.current_awaitable = nullptr;
             promise.current_awaitable_poll = nullptr;
@@ -162,9 +302,19 @@ template<typename task, typename result, typename storage>
 struct promise_type : public storage {
     const pollcoro::allocator& alloc_ = default_allocator;
 
-    promise_type() : alloc_(current_allocator()) {}
+    // The default argument is evaluated where the compiler constructs the
+    // promise, inside the coroutine, so it names the coroutine itself.
+    promise_type(std::source_location location = std::source_location::current())
+        : alloc_(current_allocator()) {
+        this->handle_ = std::coroutine_handle<promise_type>::from_promise(*this);
+        register_frame(this->record_, location);
+        this->trace_.begin(location.function_name(), "coroutine");
+        instrument_create(this->handle_.address());
+    }
 
     ~promise_type() {
+        instrument_destroy(this->handle_.address());
+        unregister_frame(this->record_);
 #ifndef NDEBUG
         if (this->exception) {
             fprintf(stderr, "Promise destroyed while exception is present\n");
@@ -173,13 +323,6 @@ struct promise_type : public storage {
 #endif
     }
 
-    bool poll_ready(const waker& w) {
-        if (this->current_awaitable_poll) {
-            return this->current_awaitable_poll(this->current_awaitable, w);
-        }
-        return true;
-    }
-
     const pollcoro::allocator& allocator() const {
         return alloc_;
     }
@@ -199,6 +342,7 @@ struct promise_type : public storage {
     }
 
     std::suspend_always final_suspend() noexcept {
+        set_frame_state(this->record_, frame_state::done);
         return {};
     }
 
@@ -12,6 +12,7 @@ export module pollcoro:flatten;
 import std;
 #endif
 
+import :budget;
 import :is_blocking;
 import :stream_awaitable;
 import :waker;
@@ -35,6 +36,9 @@ class flatten_stream_awaitable
                 auto state = inner_stream_->poll_next(w);
                 if (state.is_done()) {
                     inner_stream_.reset();
+                    if (!consume_budget(w)) {
+                        return state_type::pending();
+                    }
                     continue;
                 }
 
@@ -14,6 +14,7 @@ import std;
 #endif
 
 import :awaitable;
+import :budget;
 import :is_blocking;
 import :stream_awaitable;
 import :waker;
@@ -54,11 +55,14 @@ class fold_stream_awaitable : public awaitable_maybe_blocks<StreamAwaitable> {
           fold_function_(std::move(fold_function)) {}
 
     state_type poll(const waker& w) {
-        auto state = stream_.poll_next(w);
-        if (state.is_done()) {
-            return state_type::ready(std::move(accumulator_));
-        }
-        if (state.is_ready()) {
+        while (true) {
+            auto state = stream_.poll_next(w);
+            if (state.is_done()) {
+                return state_type::ready(std::move(accumulator_));
+            }
+            if (!state.is_ready()) {
+                return state_type::pending();
+            }
             if constexpr (std::is_same_v<fold_return_type, void>) {
                 std::invoke(fold_function_, accumulator_, state.take_result());
             } else {
@@ -66,9 +70,10 @@ class fold_stream_awaitable : public awaitable_maybe_blocks<StreamAwaitable> {
                     return state_type::ready(std::move(accumulator_));
                 }
             }
-            w.wake();
+            if (!consume_budget(w)) {
+                return state_type::pending();
+            }
         }
-        return state_type::pending();
     }
 };
 
@@ -0,0 +1,255 @@
+module;
+
+#if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#endif
+
+export module pollcoro:instrument;
+
+#if defined(POLLCORO_IMPORT_STD) && POLLCORO_IMPORT_STD == 1
+import std;
+#endif
+
+export namespace pollcoro {
+
+/// True when pollcoro is built with `POLLCORO_INSTRUMENT=1` (the
+/// `POLLCORO_INSTRUMENT` CMake option). Otherwise every hook call is compiled
+/// out and installing an `instrumentation` has no effect.
+#if defined(POLLCORO_INSTRUMENT) && POLLCORO_INSTRUMENT == 1
+inline constexpr bool instrumentation_enabled = true;
+#else
+inline constexpr bool instrumentation_enabled = false;
+#endif
+
+/// Where a poll reported through `instrumentation::on_poll` happened.
+enum class poll_site {
+    task,    // `task::poll`
+    stream,  // `stream::poll_next`
+    frame,   // The awaitable a coroutine frame is suspended on, polled by its root
+};
+
+struct poll_event {
+    /// The coroutine frame polled, stable for its lifetime and matching the
+    /// address passed to `on_create` and `on_destroy`.
+    const void* frame;
+    poll_site site;
+    /// False if the poll returned pending: the poll was spurious, in that it
+    /// made no progress visible to the caller.
+    bool ready;
+    /// Time since the executor driving this poll was last woken, or negative
+    /// if unknown, such as on the first poll or under an executor that does
+    /// not open an `instrumentation_poll_scope`.
+    std::chrono::nanoseconds since_wake;
+};
+
+/// Receives events from pollcoro's hot paths, for feeding a metrics backend.
+///
+/// Override the hooks of interest and install an instance with
+/// `set_instrumentation`. Hooks are called synchronously from whichever thread
+/// polls, wakes or destroys, possibly concurrently, so they must be
+/// thread-safe, cheap and must not throw.
+///
+/// Example:
+/// ```cpp
+/// struct poll_counter : pollcoro::instrumentation {
+///     std::atomic<std::uint64_t> polls{0}, spurious{0};
+///
+///     void on_poll(const pollcoro::poll_event& event) noexcept override {
+///         polls.fetch_add(1, std::memory_order_relaxed);
+///         if (!event.ready) {
+///             spurious.fetch_add(1, std::memory_order_relaxed);
+///         }
+///     }
+/// };
+///
+/// poll_counter counter;
+/// pollcoro::set_instrumentation(&counter);
+/// ```
+class instrumentation {
+  public:
+    virtual ~instrumentation() = default;
+
+    /// A task or stream coroutine frame was created.
+    virtual void on_create(const void* frame) noexcept {}
+
+    /// A task or stream coroutine frame is about to be destroyed. Per-frame
+    /// statistics can be flushed here.
+    virtual void on_destroy(const void* frame) noexcept {}
+
+    /// A task, stream or suspended frame was polled.
+    virtual void on_poll(const poll_event& event) noexcept {}
+
+    /// A waker was woken. `data` is the waker's data pointer, which identifies
+    /// whatever it wakes.
+    virtual void on_wake(const void* data) noexcept {}
+
+    /// `block_on` polled its awaitable.
+    virtual void on_block_on_poll(bool ready, std::chrono::nanoseconds since_wake) noexcept {}
+};
+
+/// Waker churn across all pollcoro primitives, counted when built with
+/// `POLLCORO_INSTRUMENT=1`.
+struct waker_stats {
+    /// Polls of a primitive that was still waiting, such as a queued
+    /// `mutex::lock()`, which found nothing changed. Many of these relative to
+    /// the number of waits point at a wake storm: tasks polled without cause,
+    /// for example every child of a `wait_all` whenever one of them is woken.
+    std::uint64_t spurious_wakes = 0;
+    /// Of those, polls with a waker that would not wake the stored one, which
+    /// was replaced. Many of these point at an executor that hands out a
+    /// different waker on every poll of the same task.
+    std::uint64_t waker_replacements = 0;
+};
+
+namespace detail {
+
+inline std::atomic<instrumentation*> installed_instrumentation{nullptr};
+
+struct waker_counters {
+    alignas(64) std::atomic<std::uint64_t> spurious_wakes{0};
+    alignas(64) std::atomic<std::uint64_t> waker_replacements{0};
+};
+
+inline waker_counters global_waker_counters;
+
+// When the executor polling on this thread was last woken. The epoch means
+// unknown.
+inline thread_local std::chrono::steady_clock::time_point instrumented_woken_at{};
+
+inline instrumentation* instrumentation_hooks() noexcept {
+    if constexpr (instrumentation_enabled) {
+        return installed_instrumentation.load(std::memory_order_acquire);
+    } else {
+        return nullptr;
+    }
+}
+
+// When an executor's waker was last woken, for its `instrumentation_poll_scope`.
+// Executors hold a `wake_timestamp_t`, which is empty and records nothing
+// unless instrumentation is built in.
+struct wake_timestamp {
+    std::atomic<std::chrono::steady_clock::time_point> at_{};
+
+    void record() noexcept {
+        at_.store(std::chrono::steady_clock::now(), std::memory_order_relaxed);
+    }
+
+    std::chrono::steady_clock::time_point get() const noexcept {
+        return at_.load(std::memory_order_relaxed);
+    }
+};
+
+struct empty_wake_timestamp {
+    void record() noexcept {}
+
+    std::chrono::steady_clock::time_point get() const noexcept {
+        return {};
+    }
+};
+
+using wake_timestamp_t =
+    std::conditional_t<instrumentation_enabled, wake_timestamp, empty_wake_timestamp>;
+
+inline std::chrono::nanoseconds instrumented_since_wake() noexcept {
+    if constexpr (instrumentation_enabled) {
+        if (instrumented_woken_at != std::chrono::steady_clock::time_point{}) {
+            return std::chrono::steady_clock::now() - instrumented_woken_at;
+        }
+    }
+    return std::chrono::nanoseconds(-1);
+}
+
+inline void instrument_create(const void* frame) noexcept {
+    if constexpr (instrumentation_enabled) {
+        if (auto hooks = instrumentation_hooks()) {
+            hooks->on_create(frame);
+        }
+    }
+}
+
+inline void instrument_destroy(const void* frame) noexcept {
+    if constexpr (instrumentation_enabled) {
+        if (auto hooks = instrumentation_hooks()) {
+            hooks->on_destroy(frame);
+        }
+    }
+}
+
+inline void instrument_poll(const void* frame, poll_site site, bool ready) noexcept {
+    if constexpr (instrumentation_enabled) {
+        if (auto hooks = instrumentation_hooks()) {
+            hooks->on_poll(poll_event{frame, site, ready, instrumented_since_wake()});
+        }
+    }
+}
+
+inline void instrument_wake(const void* data) noexcept {
+    if constexpr (instrumentation_enabled) {
+        if (auto hooks = instrumentation_hooks()) {
+            hooks->on_wake(data);
+        }
+    }
+}
+
+inline void instrument_rearm(bool replaced) noexcept {
+    if constexpr (instrumentation_enabled) {
+        global_waker_counters.spurious_wakes.fetch_add(1, std::memory_order_relaxed);
+        if (replaced) {
+            global_waker_counters.waker_replacements.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+}  // namespace detail
+
+/// Installs `hooks`, or removes the installed instrumentation if null, and
+/// returns the previous one. The caller keeps ownership and must keep `hooks`
+/// alive until no thread can be calling into it any more.
+inline instrumentation* set_instrumentation(instrumentation* hooks) noexcept {
+    return detail::installed_instrumentation.exchange(hooks, std::memory_order_acq_rel);
+}
+
+/// Returns the waker churn counted since startup or the last
+/// `reset_waker_stats()`. Always zero unless built with `POLLCORO_INSTRUMENT=1`.
+inline waker_stats read_waker_stats() noexcept {
+    auto& counters = detail::global_waker_counters;
+    return {
+        counters.spurious_wakes.load(std::memory_order_relaxed),
+        counters.waker_replacements.load(std::memory_order_relaxed),
+    };
+}
+
+inline void reset_waker_stats() noexcept {
+    detail::global_waker_counters.spurious_wakes.store(0, std::memory_order_relaxed);
+    detail::global_waker_counters.waker_replacements.store(0, std::memory_order_relaxed);
+}
+
+/// Tells instrumentation when the executor polling on this thread was woken,
+/// for the duration of a poll, so that polls can report their wake-to-poll
+/// latency. `block_on` opens one around every poll; custom executors can do
+/// the same by recording `steady_clock::now()` in their waker.
+class instrumentation_poll_scope {
+    std::chrono::steady_clock::time_point saved_;
+
+  public:
+    explicit instrumentation_poll_scope(std::chrono::steady_clock::time_point woken_at) noexcept {
+        if constexpr (instrumentation_enabled) {
+            saved_ = std::exchange(detail::instrumented_woken_at, woken_at);
+        }
+    }
+
+    instrumentation_poll_scope(const instrumentation_poll_scope&) = delete;
+    instrumentation_poll_scope& operator=(const instrumentation_poll_scope&) = delete;
+
+    ~instrumentation_poll_scope() {
+        if constexpr (instrumentation_enabled) {
+            detail::instrumented_woken_at = saved_;
+        }
+    }
+};
+
+}  // namespace pollcoro
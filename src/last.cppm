@@ -13,6 +13,7 @@ import std;
 #endif
 
 import :awaitable;
+import :budget;
 import :is_blocking;
 import :stream_awaitable;
 import :waker;
@@ -37,6 +38,9 @@ class last_stream_awaitable : public awaitable_maybe_blocks<StreamAwaitable> {
             }
             if (state.is_ready()) {
                 result_ = state.take_result();
+                if (!consume_budget(w)) {
+                    return state_type::pending();
+                }
                 continue;
             }
             return state_type::pending();
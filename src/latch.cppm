@@ -0,0 +1,192 @@
+module;
+
+#if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#endif
+
+export module pollcoro:latch;
+
+#if defined(POLLCORO_IMPORT_STD) && POLLCORO_IMPORT_STD == 1
+import std;
+#endif
+
+import :awaitable;
+import :is_blocking;
+import :waiter_list;
+import :waker;
+
+export namespace pollcoro {
+
+class latch;
+class latch_awaitable;
+
+namespace detail {
+
+struct latch_state {
+    std::atomic<std::ptrdiff_t> count_;
+    mutable std::mutex mtx_;
+    waiter_list waiters_;
+
+    explicit latch_state(std::ptrdiff_t expected) : count_(expected) {}
+
+    bool try_wait() const noexcept {
+        return count_.load(std::memory_order_acquire) == 0;
+    }
+
+    void count_down(std::ptrdiff_t n) {
+        if (n == 0 || count_.fetch_sub(n, std::memory_order_acq_rel) != n) {
+            return;
+        }
+        // Waiters recheck the count under `mtx_` before registering, so none
+        // can be added once the count has reached zero.
+        std::unique_lock lock(mtx_);
+        wake_batch batch;
+        while (!waiters_.empty()) {
+            if (batch.full()) {
+                lock.unlock();
+                batch.wake_all();
+                lock.lock();
+                continue;
+            }
+            batch.push(waiters_.pop_front()->waker_);
+        }
+        lock.unlock();
+        batch.wake_all();
+    }
+};
+
+}  // namespace detail
+
+/// Awaitable returned by `latch::wait` and `latch::arrive_and_wait`. Completes
+/// once the latch's counter has reached zero.
+///
+/// For `arrive_and_wait`, the counter is decremented when the awaitable is
+/// first polled.
+class latch_awaitable : public awaitable_always_blocks {
+    detail::latch_state* state_;
+    std::ptrdiff_t arrive_;
+    detail::waiter_node node_;
+    bool registered_{false};
+
+    void deregister() {
+        if (registered_ && state_) {
+            std::lock_guard lock(state_->mtx_);
+            if (node_.linked_) {
+                state_->waiters_.remove(&node_);
+            }
+            registered_ = false;
+        }
+    }
+
+    friend class latch;
+
+    latch_awaitable(detail::latch_state* state, std::ptrdiff_t arrive)
+        : state_(state), arrive_(arrive) {}
+
+  public:
+    latch_awaitable(latch_awaitable&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)),
+          arrive_(std::exchange(other.arrive_, 0)),
+          registered_(std::exchange(other.registered_, false)) {
+        if (registered_) {
+            std::lock_guard lock(state_->mtx_);
+            if (other.node_.linked_) {
+                state_->waiters_.replace(&other.node_, &node_);
+            }
+            node_.waker_ = other.node_.waker_;
+        }
+    }
+
+    latch_awaitable& operator=(latch_awaitable&&) = delete;
+    latch_awaitable(const latch_awaitable&) = delete;
+    latch_awaitable& operator=(const latch_awaitable&) = delete;
+
+    ~latch_awaitable() {
+        deregister();
+    }
+
+    awaitable_state<> poll(const waker& w) {
+        if (auto n = std::exchange(arrive_, 0)) {
+            state_->count_down(n);
+        }
+        if (state_->try_wait()) {
+            deregister();
+            return awaitable_state<>::ready();
+        }
+
+        std::lock_guard lock(state_->mtx_);
+        if (state_->count_.load(std::memory_order_acquire) == 0) {
+            if (node_.linked_) {
+                state_->waiters_.remove(&node_);
+            }
+            registered_ = false;
+            return awaitable_state<>::ready();
+        }
+        if (node_.linked_) {
+            detail::rearm_waker(node_.waker_, w);
+        } else {
+            node_.waker_ = w;
+            state_->waiters_.push_back(&node_);
+            registered_ = true;
+        }
+        return awaitable_state<>::pending();
+    }
+};
+
+/// A single-use countdown for tasks, the async counterpart of `std::latch`.
+///
+/// The counter starts at `expected` and is decremented by `count_down()`.
+/// Tasks awaiting `wait()` complete once it reaches zero; after that, every
+/// wait completes immediately. Waiters are linked intrusively through their
+/// awaitables, so waiting never allocates.
+///
+/// Example:
+/// ```cpp
+/// pollcoro::latch loaded(shards.size());
+///
+/// task<void> load(shard& s) {
+///     co_await s.load();
+///     loaded.count_down();
+/// }
+///
+/// task<void> serve() {
+///     co_await loaded.wait();
+///     // every shard is loaded
+/// }
+/// ```
+class latch {
+    detail::latch_state state_;
+
+  public:
+    explicit latch(std::ptrdiff_t expected) : state_(expected) {}
+
+    latch(const latch&) = delete;
+    latch& operator=(const latch&) = delete;
+
+    /// Decrements the counter by `n`, waking every waiter if it reaches zero.
+    /// The counter must not drop below zero.
+    void count_down(std::ptrdiff_t n = 1) {
+        state_.count_down(n);
+    }
+
+    /// Returns true if the counter has reached zero.
+    bool try_wait() const noexcept {
+        return state_.try_wait();
+    }
+
+    /// Returns an awaitable that completes once the counter reaches zero.
+    latch_awaitable wait() {
+        return latch_awaitable(&state_, 0);
+    }
+
+    /// Returns an awaitable that decrements the counter by `n` when first
+    /// polled, then waits for it to reach zero.
+    latch_awaitable arrive_and_wait(std::ptrdiff_t n = 1) {
+        return latch_awaitable(&state_, n);
+    }
+};
+
+}  // namespace pollcoro
@@ -1,10 +1,8 @@
 module;
 
 #if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
-#include <algorithm>
 #include <atomic>
-#include <deque>
-#include <memory>
+#include <cstdint>
 #include <mutex>
 #include <optional>
 #include <utility>
@@ -18,6 +16,8 @@ import std;
 
 import :awaitable;
 import :is_blocking;
+import :trace;
+import :waiter_list;
 import :waker;
 
 export namespace pollcoro {
@@ -25,38 +25,111 @@ export namespace pollcoro {
 class mutex;
 class mutex_guard;
 class mutex_lock_awaitable;
+template<typename Predicate>
+class condition_variable_awaitable;
 
 namespace detail {
 
-struct waiter {
-    waker waker_;
+struct mutex_waiter : waiter_node {
     std::atomic<bool> is_ready_{false};
 };
 
 struct mutex_state {
+    static constexpr std::uint8_t locked_bit = 1;
+    static constexpr std::uint8_t waiters_bit = 2;
+
+    // Lock word. `waiters_bit` is only set while `locked_bit` is, and only
+    // changes under `mtx_`, so an uncontended lock/unlock never touches `mtx_`.
+    std::atomic<std::uint8_t> state_{0};
     mutable std::mutex mtx_;
-    bool locked_{false};
-    std::deque<std::shared_ptr<waiter>> waiters_;
+    waiter_list waiters_;
+
+    bool try_lock() noexcept {
+        std::uint8_t expected = 0;
+        return state_.compare_exchange_strong(
+            expected, locked_bit, std::memory_order_acquire, std::memory_order_relaxed
+        );
+    }
+
+    bool is_locked() const noexcept {
+        return (state_.load(std::memory_order_relaxed) & locked_bit) != 0;
+    }
 
     void release() {
+        std::uint8_t expected = locked_bit;
+        if (state_.compare_exchange_strong(
+                expected, 0, std::memory_order_release, std::memory_order_relaxed
+            )) {
+            return;
+        }
+
         std::unique_lock lock(mtx_);
-        if (!waiters_.empty()) {
-            auto next = std::move(waiters_.front());
-            waiters_.pop_front();
-            next->is_ready_.store(true, std::memory_order_release);
-            next->waker_.wake();
-            lock.unlock();
-        } else {
-            locked_ = false;
+        if (waiters_.empty()) {
+            state_.store(0, std::memory_order_release);
+            return;
+        }
+        // Hand the lock directly to the next waiter: `locked_bit` stays set so
+        // nobody can barge in between, and the woken task finds the lock
+        // already owned instead of racing for it.
+        auto next = static_cast<mutex_waiter*>(waiters_.pop_front());
+        if (waiters_.empty()) {
+            state_.store(locked_bit, std::memory_order_relaxed);
         }
+        // Copy the waker first: once `is_ready_` is set the waiter may complete
+        // without taking `mtx_` and free its node
+        auto w = next->waker_;
+        next->is_ready_.store(true, std::memory_order_release);
+        // Wake outside `mtx_` so the woken task never blocks on it
+        lock.unlock();
+        w.wake();
     }
 
-    void remove_waiter(const std::shared_ptr<waiter>& waiter) {
+    // Must be called with `mtx_` held. Either acquires the lock, or marks it as
+    // contended so that the holder takes the slow release path.
+    bool lock_or_mark_contended() noexcept {
+        auto s = state_.load(std::memory_order_relaxed);
+        while (true) {
+            if ((s & locked_bit) == 0) {
+                if (state_.compare_exchange_weak(
+                        s, s | locked_bit, std::memory_order_acquire, std::memory_order_relaxed
+                    )) {
+                    return true;
+                }
+            } else if ((s & waiters_bit) != 0) {
+                return false;
+            } else if (state_.compare_exchange_weak(
+                           s, s | waiters_bit, std::memory_order_relaxed, std::memory_order_relaxed
+                       )) {
+                return false;
+            }
+        }
+    }
+
+    // O(1). Returns false if the waiter was no longer queued, meaning the lock
+    // has already been handed to it.
+    bool remove_waiter(mutex_waiter* waiter) {
         std::unique_lock lock(mtx_);
-        auto it = std::find(waiters_.begin(), waiters_.end(), waiter);
-        if (it != waiters_.end()) {
-            waiters_.erase(it);
+        if (!waiter->linked_) {
+            return false;
+        }
+        waiters_.remove(waiter);
+        if (waiters_.empty()) {
+            state_.fetch_and(static_cast<std::uint8_t>(~waiters_bit), std::memory_order_relaxed);
         }
+        return true;
+    }
+
+    // Moves a registered waiter's queue position and handoff state to the
+    // node of a move-constructed awaitable.
+    void relink_waiter(mutex_waiter& from, mutex_waiter& to) {
+        std::unique_lock lock(mtx_);
+        if (from.linked_) {
+            waiters_.replace(&from, &to);
+        }
+        to.waker_ = from.waker_;
+        to.is_ready_.store(
+            from.is_ready_.load(std::memory_order_relaxed), std::memory_order_relaxed
+        );
     }
 };
 
@@ -71,6 +144,8 @@ class mutex_guard {
 
     friend class mutex_lock_awaitable;
     friend class mutex;
+    template<typename Predicate>
+    friend class condition_variable_awaitable;
 
   public:
     mutex_guard(mutex_guard&& other) noexcept : state_(std::exchange(other.state_, nullptr)) {}
@@ -110,39 +185,57 @@ class mutex_guard {
 
 /// Awaitable that acquires a mutex lock. Returns a `mutex_guard` when the lock
 /// is acquired.
+///
+/// The waiter node is embedded in the awaitable and linked into the mutex's
+/// queue intrusively, so even a contended lock never allocates. Moving a
+/// registered awaitable relinks the node in place.
 class mutex_lock_awaitable : public awaitable_always_blocks {
     detail::mutex_state* state_;
-    std::shared_ptr<detail::waiter> waiter_ = std::make_shared<detail::waiter>();
+    detail::mutex_waiter node_;
     bool registered_{false};
+    [[no_unique_address]] detail::trace_span wait_span_;  // While queued, for tracing
 
     void deregister() {
-        if (registered_ && state_ && waiter_) {
-            if (waiter_->is_ready_.load(std::memory_order_acquire)) {
+        if (registered_ && state_) {
+            if (node_.is_ready_.load(std::memory_order_acquire) || !state_->remove_waiter(&node_)) {
+                // The lock was handed to us but never observed
                 state_->release();
-            } else {
-                state_->remove_waiter(waiter_);
-                registered_ = false;
             }
+            registered_ = false;
+            wait_span_.end();
         }
     }
 
     using result_type = mutex_guard;
     using state_type = awaitable_state<result_type>;
 
+    state_type acquired() {
+        registered_ = false;
+        wait_span_.end();
+        return state_type::ready(mutex_guard(std::exchange(state_, nullptr)));
+    }
+
   public:
     explicit mutex_lock_awaitable(detail::mutex_state* state) : state_(state) {}
 
     mutex_lock_awaitable(mutex_lock_awaitable&& other) noexcept
         : state_(std::exchange(other.state_, nullptr)),
-          waiter_(std::move(other.waiter_)),
-          registered_(std::exchange(other.registered_, false)) {}
+          registered_(std::exchange(other.registered_, false)),
+          wait_span_(std::move(other.wait_span_)) {
+        if (registered_) {
+            state_->relink_waiter(other.node_, node_);
+        }
+    }
 
     mutex_lock_awaitable& operator=(mutex_lock_awaitable&& other) noexcept {
         if (this != &other) {
             deregister();
             state_ = std::exchange(other.state_, nullptr);
-            waiter_ = std::move(other.waiter_);
             registered_ = std::exchange(other.registered_, false);
+            wait_span_ = std::move(other.wait_span_);
+            if (registered_) {
+                state_->relink_waiter(other.node_, node_);
+            }
         }
         return *this;
     }
@@ -155,32 +248,36 @@ class mutex_lock_awaitable : public awaitable_always_blocks {
     }
 
     state_type poll(const waker& w) {
-        // Fast check if the waiter is ready
-        if (waiter_->is_ready_.load(std::memory_order_acquire)) {
-            return state_type::ready(mutex_guard(std::exchange(state_, nullptr)));
-        }
-
-        // Update waker
-        std::unique_lock lock(state_->mtx_);
-        waiter_->waker_ = w;
-
         if (!registered_) {
-            if (!state_->locked_) {
-                state_->locked_ = true;
+            // Uncontended fast path: a single CAS
+            if (state_->try_lock()) {
                 return state_type::ready(mutex_guard(std::exchange(state_, nullptr)));
             }
 
+            std::unique_lock lock(state_->mtx_);
+            if (state_->lock_or_mark_contended()) {
+                return state_type::ready(mutex_guard(std::exchange(state_, nullptr)));
+            }
+
+            node_.waker_ = w;
             registered_ = true;
-            state_->waiters_.push_back(waiter_);
+            state_->waiters_.push_back(&node_);
+            wait_span_.begin("mutex::lock", "mutex");
             return state_type::pending();
         }
 
-        if (!waiter_->is_ready_) {
-            return state_type::pending();
+        // Fast check if the lock has been handed to us
+        if (node_.is_ready_.load(std::memory_order_acquire)) {
+            return acquired();
         }
 
-        state_->locked_ = true;
-        return state_type::ready(mutex_guard(std::exchange(state_, nullptr)));
+        // Update waker
+        std::unique_lock lock(state_->mtx_);
+        if (node_.is_ready_.load(std::memory_order_relaxed)) {
+            return acquired();
+        }
+        detail::rearm_waker(node_.waker_, w);
+        return state_type::pending();
     }
 };
 
@@ -217,9 +314,7 @@ class mutex {
     /// Returns a `mutex_guard` if successful, or `std::nullopt` if the lock
     /// is currently held.
     std::optional<mutex_guard> try_lock() {
-        std::unique_lock lock(state_.mtx_);
-        if (!state_.locked_) {
-            state_.locked_ = true;
+        if (state_.try_lock()) {
             return mutex_guard(&state_);
         }
         return std::nullopt;
@@ -228,8 +323,7 @@ class mutex {
     /// Check if the mutex is currently locked. Note that this is only a
     /// snapshot and the state may change immediately after this call returns.
     bool is_locked() const {
-        std::unique_lock lock(state_.mtx_);
-        return state_.locked_;
+        return state_.is_locked();
     }
 };
 
@@ -0,0 +1,214 @@
+module;
+
+#if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#endif
+
+export module pollcoro:notify;
+
+#if defined(POLLCORO_IMPORT_STD) && POLLCORO_IMPORT_STD == 1
+import std;
+#endif
+
+import :awaitable;
+import :is_blocking;
+import :waiter_list;
+import :waker;
+
+export namespace pollcoro {
+
+class notify;
+class notify_awaitable;
+
+namespace detail {
+
+enum class notification {
+    none,
+    one,
+    all
+};
+
+struct notify_waiter : waiter_node {
+    notification notified_{notification::none};
+    std::uint64_t epoch_{0};
+};
+
+struct notify_state {
+    mutable std::mutex mtx_;
+    bool permit_{false};
+    std::uint64_t epoch_{0};  // Number of `notify_all` calls so far
+    waiter_list waiters_;
+
+    void notify_one() {
+        std::unique_lock lock(mtx_);
+        notify_one_locked(lock);
+    }
+
+    // Wakes the waiters present when called. Waiters are queued in epoch
+    // order; stop at the first one that registered while the batch was being
+    // flushed unlocked, since it must not see this notification.
+    void notify_all() {
+        std::unique_lock lock(mtx_);
+        auto epoch = epoch_++;
+        wake_batch batch;
+        while (auto node = static_cast<notify_waiter*>(waiters_.front())) {
+            if (node->epoch_ > epoch) {
+                break;
+            }
+            if (batch.full()) {
+                lock.unlock();
+                batch.wake_all();
+                lock.lock();
+                continue;
+            }
+            waiters_.pop_front();
+            node->notified_ = notification::all;
+            batch.push(node->waker_);
+        }
+        lock.unlock();
+        batch.wake_all();
+    }
+
+    // Must be called with `mtx_` held through `lock`, which it releases.
+    void notify_one_locked(std::unique_lock<std::mutex>& lock) {
+        auto node = static_cast<notify_waiter*>(waiters_.pop_front());
+        if (!node) {
+            permit_ = true;
+            return;
+        }
+        node->notified_ = notification::one;
+        auto w = node->waker_;
+        lock.unlock();
+        w.wake();
+    }
+};
+
+}  // namespace detail
+
+/// Awaitable returned by `notify::wait`. Completes once the waiter has been
+/// notified or a stored permit has been consumed.
+class notify_awaitable : public awaitable_always_blocks {
+    detail::notify_state* state_;
+    detail::notify_waiter node_;
+    bool registered_{false};
+
+    void deregister() {
+        if (registered_ && state_) {
+            registered_ = false;
+            std::unique_lock lock(state_->mtx_);
+            if (node_.linked_) {
+                state_->waiters_.remove(&node_);
+            } else if (node_.notified_ == detail::notification::one) {
+                // Dropped before observing a `notify_one`; pass it on so the
+                // notification is not lost.
+                state_->notify_one_locked(lock);
+            }
+        }
+    }
+
+    friend class notify;
+
+    explicit notify_awaitable(detail::notify_state* state) : state_(state) {}
+
+  public:
+    notify_awaitable(notify_awaitable&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)),
+          registered_(std::exchange(other.registered_, false)) {
+        if (registered_) {
+            std::lock_guard lock(state_->mtx_);
+            if (other.node_.linked_) {
+                state_->waiters_.replace(&other.node_, &node_);
+            }
+            node_.waker_ = other.node_.waker_;
+            node_.notified_ = other.node_.notified_;
+            node_.epoch_ = other.node_.epoch_;
+        }
+    }
+
+    notify_awaitable& operator=(notify_awaitable&&) = delete;
+    notify_awaitable(const notify_awaitable&) = delete;
+    notify_awaitable& operator=(const notify_awaitable&) = delete;
+
+    ~notify_awaitable() {
+        deregister();
+    }
+
+    awaitable_state<> poll(const waker& w) {
+        std::lock_guard lock(state_->mtx_);
+        if (registered_) {
+            if (!node_.linked_) {
+                registered_ = false;
+                return awaitable_state<>::ready();
+            }
+            detail::rearm_waker(node_.waker_, w);
+            return awaitable_state<>::pending();
+        }
+
+        if (std::exchange(state_->permit_, false)) {
+            return awaitable_state<>::ready();
+        }
+
+        node_.waker_ = w;
+        node_.notified_ = detail::notification::none;
+        node_.epoch_ = state_->epoch_;
+        state_->waiters_.push_back(&node_);
+        registered_ = true;
+        return awaitable_state<>::pending();
+    }
+};
+
+/// A reusable notification primitive for repeated signalling between tasks.
+///
+/// Unlike `single_event`, a `notify` can be waited on and signalled any number
+/// of times without allocating: waiters are linked intrusively through the
+/// awaitables returned by `wait()`.
+///
+/// `notify_one()` wakes the oldest waiter, or stores a single permit if nobody
+/// is waiting so that the next `wait()` completes immediately. Repeated
+/// notifications with no waiter coalesce into that one permit. `notify_all()`
+/// wakes every current waiter and does not store a permit.
+///
+/// Example:
+/// ```cpp
+/// pollcoro::notify data_ready;
+///
+/// task<void> consumer() {
+///     while (true) {
+///         co_await data_ready.wait();
+///         drain_queue();
+///     }
+/// }
+///
+/// void producer() {
+///     push_to_queue();
+///     data_ready.notify_one();
+/// }
+/// ```
+class notify {
+    detail::notify_state state_;
+
+  public:
+    notify() = default;
+
+    notify(const notify&) = delete;
+    notify& operator=(const notify&) = delete;
+
+    /// Returns an awaitable that completes on the next notification.
+    notify_awaitable wait() {
+        return notify_awaitable(&state_);
+    }
+
+    /// Wakes a single waiter, or stores a permit if there are none.
+    void notify_one() {
+        state_.notify_one();
+    }
+
+    /// Wakes every task currently waiting.
+    void notify_all() {
+        state_.notify_all();
+    }
+};
+
+}  // namespace pollcoro
@@ -12,6 +12,7 @@ import std;
 #endif
 
 import :awaitable;
+import :budget;
 import :is_blocking;
 import :stream_awaitable;
 import :waker;
@@ -41,6 +42,9 @@ class nth_stream_awaitable : public awaitable_maybe_blocks<StreamAwaitable> {
             if (n_ == 0) {
                 return state_type::ready(std::make_optional(state.take_result()));
             }
+            if (!consume_budget(w)) {
+                return state_type::pending();
+            }
         }
     }
 };
@@ -0,0 +1,263 @@
+module;
+
+#if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#endif
+
+export module pollcoro:once_cell;
+
+#if defined(POLLCORO_IMPORT_STD) && POLLCORO_IMPORT_STD == 1
+import std;
+#endif
+
+import :awaitable;
+import :is_blocking;
+import :waiter_list;
+import :waker;
+
+export namespace pollcoro {
+
+template<typename T>
+class once_cell;
+template<typename T, typename Factory>
+class once_cell_init_awaitable;
+
+namespace detail {
+
+enum class once_cell_status : std::uint8_t {
+    empty,
+    initializing,
+    ready
+};
+
+template<typename T>
+struct once_cell_state {
+    std::atomic<once_cell_status> status_{once_cell_status::empty};
+    std::optional<T> value_;
+    mutable std::mutex mtx_;
+    waiter_list waiters_;
+
+    T* get() noexcept {
+        if (status_.load(std::memory_order_acquire) == once_cell_status::ready) {
+            return &*value_;
+        }
+        return nullptr;
+    }
+
+    // Must be called with `mtx_` held through `lock`, which it releases.
+    // Publishes the value, or gives up an abandoned initialization, and wakes
+    // every waiter: they either find the value or race to take over.
+    void finish_locked(std::unique_lock<std::mutex>& lock, once_cell_status status) {
+        status_.store(status, std::memory_order_release);
+        wake_batch batch;
+        while (auto node = waiters_.front()) {
+            if (batch.full()) {
+                lock.unlock();
+                batch.wake_all();
+                lock.lock();
+                continue;
+            }
+            waiters_.pop_front();
+            batch.push(node->waker_);
+        }
+        lock.unlock();
+        batch.wake_all();
+    }
+};
+
+}  // namespace detail
+
+/// Awaitable returned by `once_cell::get_or_init`. Yields a reference to the
+/// cell's value, running the factory first if nobody else has.
+///
+/// If the task running the initialization is dropped before it finishes, the
+/// cell returns to empty and one of the waiting tasks takes over by calling
+/// its own factory.
+template<typename T, typename Factory>
+class once_cell_init_awaitable : public awaitable_always_blocks {
+    using init_awaitable = std::invoke_result_t<Factory&>;
+    using result_type = std::reference_wrapper<T>;
+    using state_type = awaitable_state<result_type>;
+
+    detail::once_cell_state<T>* state_;
+    Factory factory_;
+    std::optional<init_awaitable> init_;
+    detail::waiter_node node_;
+    bool registered_{false};
+
+    void deregister() {
+        if (!state_ || (!registered_ && !init_)) {
+            return;
+        }
+        std::unique_lock lock(state_->mtx_);
+        if (registered_ && node_.linked_) {
+            state_->waiters_.remove(&node_);
+        }
+        registered_ = false;
+        if (init_) {
+            // Abandoned mid-initialization; let a waiter take over
+            state_->finish_locked(lock, detail::once_cell_status::empty);
+        }
+    }
+
+    friend class once_cell<T>;
+
+    once_cell_init_awaitable(detail::once_cell_state<T>* state, Factory factory)
+        : state_(state), factory_(std::move(factory)) {}
+
+  public:
+    once_cell_init_awaitable(once_cell_init_awaitable&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)),
+          factory_(std::move(other.factory_)),
+          init_(std::move(other.init_)),
+          registered_(std::exchange(other.registered_, false)) {
+        other.init_.reset();
+        if (registered_) {
+            std::lock_guard lock(state_->mtx_);
+            if (other.node_.linked_) {
+                state_->waiters_.replace(&other.node_, &node_);
+            }
+            node_.waker_ = other.node_.waker_;
+        }
+    }
+
+    once_cell_init_awaitable& operator=(once_cell_init_awaitable&&) = delete;
+    once_cell_init_awaitable(const once_cell_init_awaitable&) = delete;
+    once_cell_init_awaitable& operator=(const once_cell_init_awaitable&) = delete;
+
+    ~once_cell_init_awaitable() {
+        deregister();
+    }
+
+    state_type poll(const waker& w) {
+        // Fast path: a single acquire load once the value is set
+        if (auto value = state_->get()) {
+            deregister();
+            state_ = nullptr;
+            return state_type::ready(*value);
+        }
+
+        if (!init_) {
+            std::unique_lock lock(state_->mtx_);
+            auto status = state_->status_.load(std::memory_order_relaxed);
+            if (status == detail::once_cell_status::initializing) {
+                if (node_.linked_) {
+                    detail::rearm_waker(node_.waker_, w);
+                } else {
+                    node_.waker_ = w;
+                    state_->waiters_.push_back(&node_);
+                    registered_ = true;
+                }
+                return state_type::pending();
+            }
+            if (node_.linked_) {
+                state_->waiters_.remove(&node_);
+            }
+            registered_ = false;
+            if (status == detail::once_cell_status::ready) {
+                lock.unlock();
+                return state_type::ready(*std::exchange(state_, nullptr)->get());
+            }
+            // Empty: this task runs the initialization
+            state_->status_.store(
+                detail::once_cell_status::initializing, std::memory_order_relaxed
+            );
+            lock.unlock();
+            try {
+                init_.emplace(std::invoke(factory_));
+            } catch (...) {
+                lock.lock();
+                state_->finish_locked(lock, detail::once_cell_status::empty);
+                throw;
+            }
+        }
+
+        auto result = init_->poll(w);
+        if (!result.is_ready()) {
+            return state_type::pending();
+        }
+
+        std::unique_lock lock(state_->mtx_);
+        state_->value_.emplace(result.take_result());
+        init_.reset();
+        auto state = std::exchange(state_, nullptr);
+        state->finish_locked(lock, detail::once_cell_status::ready);
+        return state_type::ready(*state->value_);
+    }
+};
+
+/// A cell that is initialized at most once, asynchronously, on first use.
+///
+/// `get_or_init(factory)` returns the value if it is already set. Otherwise the
+/// first caller invokes `factory()`, which must return an awaitable (typically
+/// a `task<T>`) producing the value, and every concurrent caller waits for that
+/// single in-flight initialization instead of starting its own. Once set, the
+/// value never changes, and reading it is a single acquire load with no
+/// locking.
+///
+/// Example:
+/// ```cpp
+/// pollcoro::once_cell<connection_pool> pool;
+///
+/// task<void> handle_request() {
+///     connection_pool& p = co_await pool.get_or_init([] {
+///         return connect_pool();  // task<connection_pool>
+///     });
+///     co_await p.query(...);
+/// }
+/// ```
+template<typename T>
+class once_cell {
+    detail::once_cell_state<T> state_;
+
+  public:
+    once_cell() = default;
+
+    once_cell(const once_cell&) = delete;
+    once_cell& operator=(const once_cell&) = delete;
+
+    /// Returns an awaitable that yields a reference to the value, initializing
+    /// it with the awaitable returned by `factory()` if the cell is still empty.
+    template<typename Factory>
+    once_cell_init_awaitable<T, Factory> get_or_init(Factory factory) {
+        return once_cell_init_awaitable<T, Factory>(&state_, std::move(factory));
+    }
+
+    /// Returns a pointer to the value, or `nullptr` if it is not set yet.
+    T* get() noexcept {
+        return state_.get();
+    }
+
+    /// Returns a pointer to the value, or `nullptr` if it is not set yet.
+    const T* get() const noexcept {
+        if (state_.status_.load(std::memory_order_acquire) == detail::once_cell_status::ready) {
+            return &*state_.value_;
+        }
+        return nullptr;
+    }
+
+    /// Sets the value if the cell is empty and no initialization is in flight.
+    /// Returns false if the cell already has, or is computing, a value.
+    bool set(T value) {
+        std::unique_lock lock(state_.mtx_);
+        if (state_.status_.load(std::memory_order_relaxed) != detail::once_cell_status::empty) {
+            return false;
+        }
+        state_.value_.emplace(std::move(value));
+        state_.finish_locked(lock, detail::once_cell_status::ready);
+        return true;
+    }
+
+    /// Check if the value has been set.
+    bool is_initialized() const noexcept {
+        return get() != nullptr;
+    }
+};
+
+}  // namespace pollcoro
@@ -1,10 +1,13 @@
 export module pollcoro;
 
 // Core types (order matters - dependencies first)
+export import :instrument;
+export import :trace;
 export import :waker;
 export import :is_blocking;
 export import :awaitable;
 export import :stream_awaitable;
+export import :budget;
 
 // Basic awaitables
 export import :yield;
@@ -15,15 +18,27 @@ export import :pending;
 export import :ref;
 export import :generic;
 export import :map;
+export import :waiter_list;
+export import :cancellation;
 export import :single_event;
+export import :channel;
+export import :notify;
+export import :watch;
 export import :sleep;
 export import :mutex;
 export import :shared_mutex;
+export import :sharded_shared_mutex;
+export import :semaphore;
+export import :condition_variable;
+export import :once_cell;
+export import :latch;
+export import :barrier;
 
 // Allocator
 export import :allocator;
 
 // Coroutine types
+export import :task_registry;
 export import :detail_promise;
 export import :task;
 export import :stream;
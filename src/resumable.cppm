@@ -17,11 +17,73 @@ import std;
 #endif
 
 import :awaitable;
+import :budget;
 import :co_awaitable;
 import :waker;
 
 export namespace pollcoro {
 namespace detail {
+
+// Waker target of `to_resumable`. Only a coroutine suspended on a pending
+// poll is resumed; a wake that arrives while the poll is still running, such
+// as from an awaitable that wakes inline, is recorded and makes the coroutine
+// poll again instead. Recycled across calls, since a wake may still arrive
+// after the poll it belongs to has completed.
+struct resume_waker {
+    enum : int { idle, polling, woken, suspended };
+
+    std::atomic<int> state{idle};
+    std::coroutine_handle<> handle;
+
+    void begin_poll(std::coroutine_handle<> h) noexcept {
+        handle = h;
+        state.store(polling, std::memory_order_release);
+    }
+
+    // Returns true if the coroutine should stay suspended until woken
+    bool end_poll(bool ready) noexcept {
+        int expected = polling;
+        if (!ready &&
+            state.compare_exchange_strong(expected, suspended, std::memory_order_acq_rel)) {
+            return true;
+        }
+        state.store(idle, std::memory_order_release);
+        return false;
+    }
+
+    void disarm() noexcept {
+        state.store(idle, std::memory_order_release);
+    }
+
+    void wake() noexcept {
+        int s = state.load(std::memory_order_acquire);
+        while (true) {
+            if (s == polling) {
+                if (state.compare_exchange_weak(s, woken, std::memory_order_acq_rel)) {
+                    return;
+                }
+            } else if (s == suspended) {
+                if (state.compare_exchange_weak(s, idle, std::memory_order_acq_rel)) {
+                    handle.resume();
+                    return;
+                }
+            } else {
+                return;
+            }
+        }
+    }
+};
+
+// Disarms the target when the polling coroutine is destroyed, so that no late
+// wake resumes its frame
+struct resume_waker_disarm {
+    resume_waker& target;
+
+    ~resume_waker_disarm() {
+        target.disarm();
+    }
+};
+
 template<typename T>
 struct resumable_shared_state {
     using storage = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
@@ -30,6 +92,7 @@ struct resumable_shared_state {
 
     std::mutex mutex;
     bool done = false;
+    bool waiting = false;  // A waker has been stored
     pollcoro::waker waker;
     std::variant<storage, std::exception_ptr> result;
 
@@ -61,7 +124,11 @@ struct resumable_shared_state {
             }
         }
 
-        waker = w;
+        if (std::exchange(waiting, true)) {
+            pollcoro::detail::rearm_waker(waker, w);
+        } else {
+            waker = w;
+        }
         return state_type::pending();
     }
 };
@@ -215,7 +282,6 @@ auto to_resumable(Awaitable&& awaitable, Scheduler&& scheduler) {
     struct task_t {
         struct promise_type : detail::resumable_promise_storage<result_type> {
             std::coroutine_handle<> continuation;
-            std::atomic<bool> resumed{false};
 
             task_t get_return_object() {
                 return task_t{std::coroutine_handle<promise_type>::from_promise(*this)};
@@ -295,31 +361,22 @@ auto to_resumable(Awaitable&& awaitable, Scheduler&& scheduler) {
                    Scheduler&& scheduler) -> task_t {
         struct poll_awaiter {
             Awaitable& awaitable;
+            detail::resume_waker& target;
             mutable awaitable_state<result_type> state;
 
             bool await_ready() const noexcept {
                 return false;
             }
 
-            bool await_suspend(std::coroutine_handle<typename task_t::promise_type> handle) {
-                handle.promise().resumed.store(false, std::memory_order_relaxed);
-
-                state = awaitable.poll(waker(handle.address(), [](void* data) noexcept {
-                    auto h =
-                        std::coroutine_handle<typename task_t::promise_type>::from_address(data);
-                    bool expected = false;
-                    if (h.promise().resumed.compare_exchange_strong(
-                            expected, true, std::memory_order_acq_rel
-                        )) {
-                        h.resume();
-                    }
-                }));
+            bool await_suspend(std::coroutine_handle<> handle) {
+                target.begin_poll(handle);
 
-                // If already ready, resume immediately
-                if (state.is_ready()) {
-                    return false;
-                }
-                return true;
+                budget_scope budget;
+                state = awaitable.poll(waker(target));
+
+                // Resume immediately if already ready, or if woken during the
+                // poll
+                return target.end_poll(state.is_ready());
             }
 
             awaitable_state<result_type> await_resume() {
@@ -327,8 +384,10 @@ auto to_resumable(Awaitable&& awaitable, Scheduler&& scheduler) {
             }
         };
 
+        detail::recycled_waker_target<detail::resume_waker> target;
+        detail::resume_waker_disarm disarm{*target};
         while (true) {
-            auto state = co_await poll_awaiter{inner_awaitable, {}};
+            auto state = co_await poll_awaiter{inner_awaitable, *target, {}};
             if (state.is_ready()) {
                 if constexpr (std::is_void_v<result_type>) {
                     co_return;
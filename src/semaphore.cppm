@@ -0,0 +1,260 @@
+module;
+
+#if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <utility>
+#endif
+
+export module pollcoro:semaphore;
+
+#if defined(POLLCORO_IMPORT_STD) && POLLCORO_IMPORT_STD == 1
+import std;
+#endif
+
+import :awaitable;
+import :is_blocking;
+import :waiter_list;
+import :waker;
+
+export namespace pollcoro {
+
+class semaphore;
+class semaphore_permit;
+class semaphore_acquire_awaitable;
+
+namespace detail {
+
+struct semaphore_waiter : waiter_node {
+    std::size_t needed_{0};
+};
+
+struct semaphore_state {
+    mutable std::mutex mtx_;
+    std::size_t permits_{0};
+    waiter_list waiters_;
+
+    explicit semaphore_state(std::size_t permits) : permits_(permits) {}
+
+    void release(std::size_t n) {
+        std::unique_lock lock(mtx_);
+        permits_ += n;
+        grant(lock);
+    }
+
+    // Must be called with `mtx_` held through `lock`, which it releases. Hands
+    // permits to waiters strictly in FIFO order: a large request at the front
+    // holds back smaller ones behind it. Granted waiters are unlinked, which is
+    // how they learn they own their permits, and woken once `mtx_` has been
+    // released.
+    void grant(std::unique_lock<std::mutex>& lock) {
+        wake_batch batch;
+        while (auto front = static_cast<semaphore_waiter*>(waiters_.front())) {
+            if (front->needed_ > permits_) {
+                break;
+            }
+            if (batch.full()) {
+                lock.unlock();
+                batch.wake_all();
+                lock.lock();
+                continue;
+            }
+            permits_ -= front->needed_;
+            waiters_.pop_front();
+            batch.push(front->waker_);
+        }
+        lock.unlock();
+        batch.wake_all();
+    }
+};
+
+}  // namespace detail
+
+/// RAII guard that holds permits from a semaphore. The permits are returned
+/// when the guard is destroyed or when `release()` is called explicitly.
+class semaphore_permit {
+    detail::semaphore_state* state_;
+    std::size_t count_;
+
+    semaphore_permit(detail::semaphore_state* state, std::size_t count)
+        : state_(state), count_(count) {}
+
+    friend class semaphore_acquire_awaitable;
+    friend class semaphore;
+
+  public:
+    semaphore_permit(semaphore_permit&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)), count_(std::exchange(other.count_, 0)) {}
+
+    semaphore_permit& operator=(semaphore_permit&& other) noexcept {
+        if (this != &other) {
+            release();
+            state_ = std::exchange(other.state_, nullptr);
+            count_ = std::exchange(other.count_, 0);
+        }
+        return *this;
+    }
+
+    semaphore_permit(const semaphore_permit&) = delete;
+    semaphore_permit& operator=(const semaphore_permit&) = delete;
+
+    ~semaphore_permit() {
+        release();
+    }
+
+    /// Explicitly return the permits before the guard is destroyed.
+    void release() {
+        if (state_) {
+            std::exchange(state_, nullptr)->release(std::exchange(count_, 0));
+        }
+    }
+
+    /// Number of permits held by this guard.
+    std::size_t count() const noexcept {
+        return count_;
+    }
+
+    /// Check if this guard still holds its permits.
+    explicit operator bool() const noexcept {
+        return state_ != nullptr;
+    }
+};
+
+/// Awaitable that acquires permits from a semaphore. Returns a
+/// `semaphore_permit` once all requested permits are available.
+class semaphore_acquire_awaitable : public awaitable_always_blocks {
+    detail::semaphore_state* state_;
+    detail::semaphore_waiter node_;
+    bool registered_{false};
+
+    void deregister() {
+        if (registered_ && state_) {
+            registered_ = false;
+            std::unique_lock lock(state_->mtx_);
+            if (node_.linked_) {
+                state_->waiters_.remove(&node_);
+            } else {
+                // Permits were granted but never observed; give them back.
+                state_->permits_ += node_.needed_;
+            }
+            // Either way the front of the queue may now be satisfiable.
+            state_->grant(lock);
+        }
+    }
+
+    using result_type = semaphore_permit;
+    using state_type = awaitable_state<result_type>;
+
+    friend class semaphore;
+
+    semaphore_acquire_awaitable(detail::semaphore_state* state, std::size_t n) : state_(state) {
+        node_.needed_ = n;
+    }
+
+  public:
+    semaphore_acquire_awaitable(semaphore_acquire_awaitable&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)),
+          registered_(std::exchange(other.registered_, false)) {
+        node_.needed_ = other.node_.needed_;
+        if (registered_) {
+            std::lock_guard lock(state_->mtx_);
+            if (other.node_.linked_) {
+                state_->waiters_.replace(&other.node_, &node_);
+            }
+            node_.waker_ = other.node_.waker_;
+        }
+    }
+
+    semaphore_acquire_awaitable& operator=(semaphore_acquire_awaitable&&) = delete;
+    semaphore_acquire_awaitable(const semaphore_acquire_awaitable&) = delete;
+    semaphore_acquire_awaitable& operator=(const semaphore_acquire_awaitable&) = delete;
+
+    ~semaphore_acquire_awaitable() {
+        deregister();
+    }
+
+    state_type poll(const waker& w) {
+        std::lock_guard lock(state_->mtx_);
+        if (registered_) {
+            if (!node_.linked_) {
+                registered_ = false;
+                return state_type::ready(
+                    semaphore_permit(std::exchange(state_, nullptr), node_.needed_)
+                );
+            }
+            detail::rearm_waker(node_.waker_, w);
+            return state_type::pending();
+        }
+
+        // Only take permits directly if nobody is queued ahead of us (FIFO)
+        if (state_->waiters_.empty() && state_->permits_ >= node_.needed_) {
+            state_->permits_ -= node_.needed_;
+            return state_type::ready(
+                semaphore_permit(std::exchange(state_, nullptr), node_.needed_)
+            );
+        }
+
+        node_.waker_ = w;
+        state_->waiters_.push_back(&node_);
+        registered_ = true;
+        return state_type::pending();
+    }
+};
+
+/// An async counting semaphore.
+///
+/// Tasks acquire one or more permits and return them when the resulting
+/// `semaphore_permit` is dropped. Waiters are served in FIFO order, so a task
+/// asking for many permits is not starved by a stream of small requests.
+///
+/// Example:
+/// ```cpp
+/// pollcoro::semaphore connections(8);
+///
+/// task<void> request() {
+///     auto permit = co_await connections.acquire();
+///     co_await send_request();
+///     // permit returned when it goes out of scope
+/// }
+/// ```
+class semaphore {
+    detail::semaphore_state state_;
+
+  public:
+    explicit semaphore(std::size_t permits) : state_(permits) {}
+
+    semaphore(const semaphore&) = delete;
+    semaphore& operator=(const semaphore&) = delete;
+
+    /// Returns an awaitable that acquires `n` permits. The returned awaitable
+    /// yields a `semaphore_permit` that returns them when destroyed.
+    semaphore_acquire_awaitable acquire(std::size_t n = 1) {
+        return semaphore_acquire_awaitable(&state_, n);
+    }
+
+    /// Attempts to acquire `n` permits immediately without blocking. Fails if
+    /// not enough permits are available or other tasks are already waiting.
+    std::optional<semaphore_permit> try_acquire(std::size_t n = 1) {
+        std::lock_guard lock(state_.mtx_);
+        if (state_.waiters_.empty() && state_.permits_ >= n) {
+            state_.permits_ -= n;
+            return semaphore_permit(&state_, n);
+        }
+        return std::nullopt;
+    }
+
+    /// Adds `n` permits to the semaphore, waking waiters that can now proceed.
+    void release(std::size_t n = 1) {
+        state_.release(n);
+    }
+
+    /// Returns the number of permits currently available. Note that this is
+    /// only a snapshot and may change immediately after this call returns.
+    std::size_t available_permits() const {
+        std::lock_guard lock(state_.mtx_);
+        return state_.permits_;
+    }
+};
+
+}  // namespace pollcoro
@@ -0,0 +1,1006 @@
+module;
+
+#if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#endif
+
+export module pollcoro:sharded_shared_mutex;
+
+#if defined(POLLCORO_IMPORT_STD) && POLLCORO_IMPORT_STD == 1
+import std;
+#endif
+
+import :awaitable;
+import :is_blocking;
+import :shared_mutex;
+import :waiter_list;
+import :waker;
+
+export namespace pollcoro {
+
+class sharded_shared_mutex;
+class sharded_shared_lock_guard;
+class sharded_unique_lock_guard;
+class sharded_upgradable_lock_guard;
+class sharded_shared_mutex_read_awaitable;
+class sharded_shared_mutex_write_awaitable;
+class sharded_shared_mutex_upgradable_awaitable;
+class sharded_shared_mutex_upgrade_awaitable;
+
+namespace detail {
+
+struct alignas(cache_line_size) reader_shard {
+    std::atomic<std::size_t> count_{0};
+};
+
+struct sharded_waiter : waiter_node {
+    std::atomic<bool> is_ready_{false};
+    shared_lock_kind kind_{shared_lock_kind::read};
+    // Shard a queued reader or upgradable holder is counted in once admitted,
+    // or that a pending upgrade's upgradable lock is counted in
+    reader_shard* shard_{nullptr};
+};
+
+struct sharded_shared_mutex_state {
+    std::unique_ptr<reader_shard[]> shards_;
+    std::size_t mask_;
+    // Set while a writer holds the lock or anyone is queued. Readers announce
+    // themselves in their shard first and then check this flag, while writers
+    // set it first and then sum the shards, so at least one side always sees
+    // the other (both use seq_cst).
+    alignas(cache_line_size) std::atomic<bool> writer_{false};
+    mutable std::mutex mtx_;
+    waiter_list waiters_;
+    bool writer_held_{false};
+    // An upgradable holder is also counted as a reader in its shard
+    bool upgrader_held_{false};
+
+    static std::size_t default_shard_count() noexcept {
+        auto threads = static_cast<std::size_t>(std::thread::hardware_concurrency());
+        return std::clamp<std::size_t>(threads, 1, 64);
+    }
+
+    explicit sharded_shared_mutex_state(std::size_t shards)
+        : mask_(std::bit_ceil(std::max<std::size_t>(shards, 1)) - 1) {
+        shards_ = std::make_unique<reader_shard[]>(mask_ + 1);
+    }
+
+    std::size_t shard_count() const noexcept {
+        return mask_ + 1;
+    }
+
+    // Threads are spread over the shards round-robin on first use
+    reader_shard* local_shard() noexcept {
+        static std::atomic<std::size_t> next_index{0};
+        thread_local const std::size_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+        return &shards_[index & mask_];
+    }
+
+    std::size_t readers() const noexcept {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            total += shards_[i].count_.load(std::memory_order_seq_cst);
+        }
+        return total;
+    }
+
+    // Touches only this thread's shard unless a writer is active or waiting.
+    reader_shard* try_lock_shared_fast() {
+        auto shard = local_shard();
+        shard->count_.fetch_add(1, std::memory_order_seq_cst);
+        if (!writer_.load(std::memory_order_seq_cst)) {
+            return shard;
+        }
+        // Back out; a writer may be waiting for exactly this shard to drain
+        release_shared(shard);
+        return nullptr;
+    }
+
+    void release_shared(reader_shard* shard) {
+        shard->count_.fetch_sub(1, std::memory_order_seq_cst);
+        if (writer_.load(std::memory_order_seq_cst)) {
+            std::unique_lock lock(mtx_);
+            admit_waiters(lock);
+        }
+    }
+
+    void release_exclusive() {
+        std::unique_lock lock(mtx_);
+        writer_held_ = false;
+        admit_waiters(lock);
+    }
+
+    void release_upgradable(reader_shard* shard) {
+        std::unique_lock lock(mtx_);
+        upgrader_held_ = false;
+        shard->count_.fetch_sub(1, std::memory_order_seq_cst);
+        admit_waiters(lock);
+    }
+
+    // Turns the exclusive lock into a shared one counted in `shard`, admitting
+    // the readers queued behind it.
+    void downgrade_exclusive(reader_shard* shard) {
+        std::unique_lock lock(mtx_);
+        shard->count_.fetch_add(1, std::memory_order_seq_cst);
+        writer_held_ = false;
+        admit_waiters(lock);
+    }
+
+    // Turns the upgradable lock into a plain shared one in the same shard.
+    void downgrade_upgradable() {
+        std::unique_lock lock(mtx_);
+        upgrader_held_ = false;
+        admit_waiters(lock);
+    }
+
+    // Must be called with `mtx_` held. Readers only get in when no writer
+    // holds the lock or is queued (writer preference).
+    bool lock_shared_locked(reader_shard* shard) noexcept {
+        if (writer_held_ || !waiters_.empty()) {
+            return false;
+        }
+        shard->count_.fetch_add(1, std::memory_order_seq_cst);
+        return true;
+    }
+
+    // Must be called with `mtx_` held. Like `lock_shared_locked`, but also
+    // waits for any other upgradable holder to leave.
+    bool lock_upgradable_locked(reader_shard* shard) noexcept {
+        if (writer_held_ || upgrader_held_ || !waiters_.empty()) {
+            return false;
+        }
+        shard->count_.fetch_add(1, std::memory_order_seq_cst);
+        upgrader_held_ = true;
+        return true;
+    }
+
+    // Must be called with `mtx_` held. On failure `writer_` stays set, so the
+    // caller must either queue or call `cancel_writer_intent`.
+    bool lock_locked() noexcept {
+        if (writer_held_ || !waiters_.empty()) {
+            return false;
+        }
+        writer_.store(true, std::memory_order_seq_cst);
+        if (readers() != 0) {
+            return false;
+        }
+        writer_held_ = true;
+        return true;
+    }
+
+    // Must be called with `mtx_` held by the upgradable holder counted in
+    // `shard`. Raises `writer_` like `lock_locked` and upgrades once every
+    // other reader has left; queued writers cannot get in first because the
+    // upgradable lock still counts as a reader. On failure the caller queues.
+    bool upgrade_locked(reader_shard* shard) noexcept {
+        writer_.store(true, std::memory_order_seq_cst);
+        if (readers() != 1) {
+            return false;
+        }
+        shard->count_.fetch_sub(1, std::memory_order_seq_cst);
+        upgrader_held_ = false;
+        writer_held_ = true;
+        return true;
+    }
+
+    // Must be called with `mtx_` held. A pending upgrade jumps the queue: it
+    // already holds part of the lock, and nothing behind it could proceed
+    // before it anyway. Raises `writer_` whatever the kind, so that readers
+    // leaving through the fast path come back to admit the queue.
+    void push_waiter(sharded_waiter* waiter) {
+        writer_.store(true, std::memory_order_seq_cst);
+        if (waiter->kind_ == shared_lock_kind::upgrade) {
+            waiters_.push_front(waiter);
+        } else {
+            waiters_.push_back(waiter);
+        }
+    }
+
+    // Must be called with `mtx_` held. Clears `writer_` after a failed
+    // `lock_locked` that is not followed by queueing.
+    void cancel_writer_intent() noexcept {
+        if (!writer_held_ && waiters_.empty()) {
+            writer_.store(false, std::memory_order_seq_cst);
+        }
+    }
+
+    // O(1). Returns false if the waiter was no longer queued, meaning the lock
+    // has already been handed to it.
+    bool remove_waiter(sharded_waiter* waiter) {
+        std::unique_lock lock(mtx_);
+        if (!waiter->linked_) {
+            return false;
+        }
+        waiters_.remove(waiter);
+        // Removing a queued writer may unblock the readers behind it
+        admit_waiters(lock);
+        return true;
+    }
+
+    // Moves a registered waiter's queue position and handoff state to the
+    // node of a move-constructed awaitable.
+    void relink_waiter(sharded_waiter& from, sharded_waiter& to) {
+        std::unique_lock lock(mtx_);
+        if (from.linked_) {
+            waiters_.replace(&from, &to);
+        }
+        to.waker_ = from.waker_;
+        to.kind_ = from.kind_;
+        to.shard_ = from.shard_;
+        to.is_ready_.store(
+            from.is_ready_.load(std::memory_order_relaxed), std::memory_order_relaxed
+        );
+    }
+
+  private:
+    bool can_hand_off(const sharded_waiter& waiter) const noexcept {
+        switch (waiter.kind_) {
+            case shared_lock_kind::read:
+                return true;
+            case shared_lock_kind::upgradable:
+                return !upgrader_held_;
+            case shared_lock_kind::write:
+                return readers() == 0;
+            case shared_lock_kind::upgrade:
+                return readers() == 1;
+        }
+        return false;
+    }
+
+    void hand_off(sharded_waiter& waiter) noexcept {
+        switch (waiter.kind_) {
+            case shared_lock_kind::read:
+                waiter.shard_->count_.fetch_add(1, std::memory_order_seq_cst);
+                break;
+            case shared_lock_kind::upgradable:
+                waiter.shard_->count_.fetch_add(1, std::memory_order_seq_cst);
+                upgrader_held_ = true;
+                break;
+            case shared_lock_kind::write:
+                writer_held_ = true;
+                break;
+            case shared_lock_kind::upgrade:
+                waiter.shard_->count_.fetch_sub(1, std::memory_order_seq_cst);
+                upgrader_held_ = false;
+                writer_held_ = true;
+                break;
+        }
+    }
+
+    // Must be called with `mtx_` held through `lock`, which it releases. Hands
+    // the lock to the waiters at the front of the queue until one of them
+    // cannot proceed: a run of readers is admitted together, while a writer
+    // or upgrade is admitted alone once every other shard has drained. Wakers
+    // are invoked after unlocking.
+    void admit_waiters(std::unique_lock<std::mutex>& lock) {
+        wake_batch batch;
+        while (auto front = static_cast<sharded_waiter*>(waiters_.front())) {
+            if (writer_held_ || !can_hand_off(*front)) {
+                break;
+            }
+            if (batch.full()) {
+                lock.unlock();
+                batch.wake_all();
+                lock.lock();
+                continue;
+            }
+            waiters_.pop_front();
+            hand_off(*front);
+            // Copy the waker first: once `is_ready_` is set the waiter may
+            // complete without taking `mtx_` and free its node
+            batch.push(front->waker_);
+            front->is_ready_.store(true, std::memory_order_release);
+        }
+
+        cancel_writer_intent();
+        lock.unlock();
+        batch.wake_all();
+    }
+};
+
+}  // namespace detail
+
+/// RAII guard that holds a shared (read) lock on a `sharded_shared_mutex`. The
+/// lock is released when the guard is destroyed or when `unlock()` is called
+/// explicitly.
+class sharded_shared_lock_guard {
+    detail::sharded_shared_mutex_state* state_;
+    detail::reader_shard* shard_;
+
+    sharded_shared_lock_guard(
+        detail::sharded_shared_mutex_state* state, detail::reader_shard* shard
+    )
+        : state_(state), shard_(shard) {}
+
+    friend class sharded_shared_mutex_read_awaitable;
+    friend class sharded_unique_lock_guard;
+    friend class sharded_upgradable_lock_guard;
+    friend class sharded_shared_mutex;
+
+  public:
+    sharded_shared_lock_guard(sharded_shared_lock_guard&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)), shard_(other.shard_) {}
+
+    sharded_shared_lock_guard& operator=(sharded_shared_lock_guard&& other) noexcept {
+        if (this != &other) {
+            if (state_) {
+                state_->release_shared(shard_);
+            }
+            state_ = std::exchange(other.state_, nullptr);
+            shard_ = other.shard_;
+        }
+        return *this;
+    }
+
+    sharded_shared_lock_guard(const sharded_shared_lock_guard&) = delete;
+    sharded_shared_lock_guard& operator=(const sharded_shared_lock_guard&) = delete;
+
+    ~sharded_shared_lock_guard() {
+        if (state_) {
+            state_->release_shared(shard_);
+        }
+    }
+
+    /// Explicitly release the lock before the guard is destroyed.
+    void unlock() {
+        if (state_) {
+            state_->release_shared(shard_);
+            state_ = nullptr;
+        }
+    }
+
+    /// Check if this guard still holds the lock.
+    explicit operator bool() const noexcept {
+        return state_ != nullptr;
+    }
+};
+
+/// RAII guard that holds an exclusive (write) lock on a `sharded_shared_mutex`.
+/// The lock is released when the guard is destroyed or when `unlock()` is
+/// called explicitly.
+class sharded_unique_lock_guard {
+    detail::sharded_shared_mutex_state* state_;
+
+    explicit sharded_unique_lock_guard(detail::sharded_shared_mutex_state* state)
+        : state_(state) {}
+
+    friend class sharded_shared_mutex_write_awaitable;
+    friend class sharded_shared_mutex_upgrade_awaitable;
+    friend class sharded_shared_mutex;
+
+  public:
+    sharded_unique_lock_guard(sharded_unique_lock_guard&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)) {}
+
+    sharded_unique_lock_guard& operator=(sharded_unique_lock_guard&& other) noexcept {
+        if (this != &other) {
+            if (state_) {
+                state_->release_exclusive();
+            }
+            state_ = std::exchange(other.state_, nullptr);
+        }
+        return *this;
+    }
+
+    sharded_unique_lock_guard(const sharded_unique_lock_guard&) = delete;
+    sharded_unique_lock_guard& operator=(const sharded_unique_lock_guard&) = delete;
+
+    ~sharded_unique_lock_guard() {
+        if (state_) {
+            state_->release_exclusive();
+        }
+    }
+
+    /// Explicitly release the lock before the guard is destroyed.
+    void unlock() {
+        if (state_) {
+            state_->release_exclusive();
+            state_ = nullptr;
+        }
+    }
+
+    /// Atomically turns the exclusive lock into a shared one. No writer can
+    /// acquire the lock in between, and queued readers are admitted alongside
+    /// the returned guard. This guard no longer holds the lock afterwards.
+    sharded_shared_lock_guard downgrade() {
+        auto shard = state_->local_shard();
+        state_->downgrade_exclusive(shard);
+        return sharded_shared_lock_guard(std::exchange(state_, nullptr), shard);
+    }
+
+    /// Check if this guard still holds the lock.
+    explicit operator bool() const noexcept {
+        return state_ != nullptr;
+    }
+};
+
+/// Awaitable returned by `sharded_upgradable_lock_guard::upgrade()`. Holds the
+/// upgradable lock while pending and yields a `sharded_unique_lock_guard` once
+/// every other reader has released. Dropping it before completion releases the
+/// upgradable lock.
+class sharded_shared_mutex_upgrade_awaitable : public awaitable_always_blocks {
+    detail::sharded_shared_mutex_state* state_;
+    detail::sharded_waiter node_;
+    bool registered_{false};
+
+    void release() {
+        if (!state_) {
+            return;
+        }
+        if (registered_) {
+            registered_ = false;
+            if (node_.is_ready_.load(std::memory_order_acquire) ||
+                !state_->remove_waiter(&node_)) {
+                // The upgrade went through but was never observed
+                state_->release_exclusive();
+                return;
+            }
+        }
+        state_->release_upgradable(node_.shard_);
+    }
+
+    using result_type = sharded_unique_lock_guard;
+    using state_type = awaitable_state<result_type>;
+
+    friend class sharded_upgradable_lock_guard;
+
+    sharded_shared_mutex_upgrade_awaitable(
+        detail::sharded_shared_mutex_state* state, detail::reader_shard* shard
+    )
+        : state_(state) {
+        node_.kind_ = detail::shared_lock_kind::upgrade;
+        node_.shard_ = shard;
+    }
+
+  public:
+    sharded_shared_mutex_upgrade_awaitable(sharded_shared_mutex_upgrade_awaitable&& other
+    ) noexcept
+        : state_(std::exchange(other.state_, nullptr)),
+          registered_(std::exchange(other.registered_, false)) {
+        node_.kind_ = detail::shared_lock_kind::upgrade;
+        node_.shard_ = other.node_.shard_;
+        if (registered_) {
+            state_->relink_waiter(other.node_, node_);
+        }
+    }
+
+    sharded_shared_mutex_upgrade_awaitable&
+    operator=(sharded_shared_mutex_upgrade_awaitable&& other) noexcept {
+        if (this != &other) {
+            release();
+            state_ = std::exchange(other.state_, nullptr);
+            registered_ = std::exchange(other.registered_, false);
+            node_.shard_ = other.node_.shard_;
+            if (registered_) {
+                state_->relink_waiter(other.node_, node_);
+            }
+        }
+        return *this;
+    }
+
+    sharded_shared_mutex_upgrade_awaitable(const sharded_shared_mutex_upgrade_awaitable&) =
+        delete;
+    sharded_shared_mutex_upgrade_awaitable&
+    operator=(const sharded_shared_mutex_upgrade_awaitable&) = delete;
+
+    ~sharded_shared_mutex_upgrade_awaitable() {
+        release();
+    }
+
+    state_type poll(const waker& w) {
+        if (!registered_) {
+            std::unique_lock lock(state_->mtx_);
+            if (state_->upgrade_locked(node_.shard_)) {
+                return state_type::ready(sharded_unique_lock_guard(std::exchange(state_, nullptr)));
+            }
+
+            // The remaining readers admit us when the last one leaves
+            node_.waker_ = w;
+            registered_ = true;
+            state_->push_waiter(&node_);
+            return state_type::pending();
+        }
+
+        // Fast check if the upgrade has been granted
+        if (node_.is_ready_.load(std::memory_order_acquire)) {
+            registered_ = false;
+            return state_type::ready(sharded_unique_lock_guard(std::exchange(state_, nullptr)));
+        }
+
+        std::unique_lock lock(state_->mtx_);
+        if (node_.is_ready_.load(std::memory_order_relaxed)) {
+            registered_ = false;
+            return state_type::ready(sharded_unique_lock_guard(std::exchange(state_, nullptr)));
+        }
+        detail::rearm_waker(node_.waker_, w);
+        return state_type::pending();
+    }
+};
+
+/// RAII guard that holds an upgradable lock on a `sharded_shared_mutex`: a
+/// shared lock that coexists with plain readers but excludes writers and other
+/// upgradable holders, and can therefore be turned into an exclusive lock
+/// without being released first. The lock is released when the guard is
+/// destroyed or when `unlock()` is called explicitly.
+class sharded_upgradable_lock_guard {
+    detail::sharded_shared_mutex_state* state_;
+    detail::reader_shard* shard_;
+
+    sharded_upgradable_lock_guard(
+        detail::sharded_shared_mutex_state* state, detail::reader_shard* shard
+    )
+        : state_(state), shard_(shard) {}
+
+    friend class sharded_shared_mutex_upgradable_awaitable;
+    friend class sharded_shared_mutex;
+
+  public:
+    sharded_upgradable_lock_guard(sharded_upgradable_lock_guard&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)), shard_(other.shard_) {}
+
+    sharded_upgradable_lock_guard& operator=(sharded_upgradable_lock_guard&& other) noexcept {
+        if (this != &other) {
+            if (state_) {
+                state_->release_upgradable(shard_);
+            }
+            state_ = std::exchange(other.state_, nullptr);
+            shard_ = other.shard_;
+        }
+        return *this;
+    }
+
+    sharded_upgradable_lock_guard(const sharded_upgradable_lock_guard&) = delete;
+    sharded_upgradable_lock_guard& operator=(const sharded_upgradable_lock_guard&) = delete;
+
+    ~sharded_upgradable_lock_guard() {
+        if (state_) {
+            state_->release_upgradable(shard_);
+        }
+    }
+
+    /// Explicitly release the lock before the guard is destroyed.
+    void unlock() {
+        if (state_) {
+            state_->release_upgradable(shard_);
+            state_ = nullptr;
+        }
+    }
+
+    /// Returns an awaitable that atomically upgrades to an exclusive lock once
+    /// the remaining readers have released theirs. New readers queue behind the
+    /// pending upgrade. Ownership moves into the awaitable, so this guard no
+    /// longer holds the lock afterwards.
+    sharded_shared_mutex_upgrade_awaitable upgrade() {
+        return sharded_shared_mutex_upgrade_awaitable(std::exchange(state_, nullptr), shard_);
+    }
+
+    /// Turns the upgradable lock into a plain shared lock, letting another task
+    /// take the upgradable lock. This guard no longer holds the lock afterwards.
+    sharded_shared_lock_guard downgrade() {
+        state_->downgrade_upgradable();
+        return sharded_shared_lock_guard(std::exchange(state_, nullptr), shard_);
+    }
+
+    /// Check if this guard still holds the lock.
+    explicit operator bool() const noexcept {
+        return state_ != nullptr;
+    }
+};
+
+/// Awaitable that acquires a shared (read) lock on a `sharded_shared_mutex`.
+/// Returns a `sharded_shared_lock_guard` when the lock is acquired.
+class sharded_shared_mutex_read_awaitable : public awaitable_always_blocks {
+    detail::sharded_shared_mutex_state* state_;
+    detail::sharded_waiter node_;
+    bool registered_{false};
+
+    void deregister() {
+        if (registered_ && state_) {
+            if (node_.is_ready_.load(std::memory_order_acquire) ||
+                !state_->remove_waiter(&node_)) {
+                // The lock was handed to us but never observed
+                state_->release_shared(node_.shard_);
+            }
+            registered_ = false;
+        }
+    }
+
+    using result_type = sharded_shared_lock_guard;
+    using state_type = awaitable_state<result_type>;
+
+  public:
+    explicit sharded_shared_mutex_read_awaitable(detail::sharded_shared_mutex_state* state)
+        : state_(state) {}
+
+    sharded_shared_mutex_read_awaitable(sharded_shared_mutex_read_awaitable&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)),
+          registered_(std::exchange(other.registered_, false)) {
+        if (registered_) {
+            state_->relink_waiter(other.node_, node_);
+        }
+    }
+
+    sharded_shared_mutex_read_awaitable& operator=(sharded_shared_mutex_read_awaitable&& other
+    ) noexcept {
+        if (this != &other) {
+            deregister();
+            state_ = std::exchange(other.state_, nullptr);
+            registered_ = std::exchange(other.registered_, false);
+            if (registered_) {
+                state_->relink_waiter(other.node_, node_);
+            }
+        }
+        return *this;
+    }
+
+    sharded_shared_mutex_read_awaitable(const sharded_shared_mutex_read_awaitable&) = delete;
+    sharded_shared_mutex_read_awaitable&
+    operator=(const sharded_shared_mutex_read_awaitable&) = delete;
+
+    ~sharded_shared_mutex_read_awaitable() {
+        deregister();
+    }
+
+    state_type poll(const waker& w) {
+        if (!registered_) {
+            // Fast path: one atomic increment on this thread's own cache line
+            if (auto shard = state_->try_lock_shared_fast()) {
+                return state_type::ready(
+                    sharded_shared_lock_guard(std::exchange(state_, nullptr), shard)
+                );
+            }
+
+            auto shard = state_->local_shard();
+            std::unique_lock lock(state_->mtx_);
+            if (state_->lock_shared_locked(shard)) {
+                return state_type::ready(
+                    sharded_shared_lock_guard(std::exchange(state_, nullptr), shard)
+                );
+            }
+
+            node_.waker_ = w;
+            node_.kind_ = detail::shared_lock_kind::read;
+            node_.shard_ = shard;
+            registered_ = true;
+            state_->push_waiter(&node_);
+            return state_type::pending();
+        }
+
+        // Fast check if the lock has been handed to us
+        if (node_.is_ready_.load(std::memory_order_acquire)) {
+            registered_ = false;
+            return state_type::ready(
+                sharded_shared_lock_guard(std::exchange(state_, nullptr), node_.shard_)
+            );
+        }
+
+        std::unique_lock lock(state_->mtx_);
+        if (node_.is_ready_.load(std::memory_order_relaxed)) {
+            registered_ = false;
+            return state_type::ready(
+                sharded_shared_lock_guard(std::exchange(state_, nullptr), node_.shard_)
+            );
+        }
+        detail::rearm_waker(node_.waker_, w);
+        return state_type::pending();
+    }
+};
+
+/// Awaitable that acquires an exclusive (write) lock on a
+/// `sharded_shared_mutex`. Returns a `sharded_unique_lock_guard` when the lock
+/// is acquired.
+class sharded_shared_mutex_write_awaitable : public awaitable_always_blocks {
+    detail::sharded_shared_mutex_state* state_;
+    detail::sharded_waiter node_;
+    bool registered_{false};
+
+    void deregister() {
+        if (registered_ && state_) {
+            if (node_.is_ready_.load(std::memory_order_acquire) ||
+                !state_->remove_waiter(&node_)) {
+                // The lock was handed to us but never observed
+                state_->release_exclusive();
+            }
+            registered_ = false;
+        }
+    }
+
+    using result_type = sharded_unique_lock_guard;
+    using state_type = awaitable_state<result_type>;
+
+  public:
+    explicit sharded_shared_mutex_write_awaitable(detail::sharded_shared_mutex_state* state)
+        : state_(state) {}
+
+    sharded_shared_mutex_write_awaitable(sharded_shared_mutex_write_awaitable&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)),
+          registered_(std::exchange(other.registered_, false)) {
+        if (registered_) {
+            state_->relink_waiter(other.node_, node_);
+        }
+    }
+
+    sharded_shared_mutex_write_awaitable& operator=(sharded_shared_mutex_write_awaitable&& other
+    ) noexcept {
+        if (this != &other) {
+            deregister();
+            state_ = std::exchange(other.state_, nullptr);
+            registered_ = std::exchange(other.registered_, false);
+            if (registered_) {
+                state_->relink_waiter(other.node_, node_);
+            }
+        }
+        return *this;
+    }
+
+    sharded_shared_mutex_write_awaitable(const sharded_shared_mutex_write_awaitable&) = delete;
+    sharded_shared_mutex_write_awaitable&
+    operator=(const sharded_shared_mutex_write_awaitable&) = delete;
+
+    ~sharded_shared_mutex_write_awaitable() {
+        deregister();
+    }
+
+    state_type poll(const waker& w) {
+        if (!registered_) {
+            std::unique_lock lock(state_->mtx_);
+            if (state_->lock_locked()) {
+                return state_type::ready(sharded_unique_lock_guard(std::exchange(state_, nullptr)));
+            }
+
+            // Readers that are still draining admit us when the last one leaves
+            node_.waker_ = w;
+            node_.kind_ = detail::shared_lock_kind::write;
+            registered_ = true;
+            state_->push_waiter(&node_);
+            return state_type::pending();
+        }
+
+        // Fast check if the lock has been handed to us
+        if (node_.is_ready_.load(std::memory_order_acquire)) {
+            registered_ = false;
+            return state_type::ready(sharded_unique_lock_guard(std::exchange(state_, nullptr)));
+        }
+
+        std::unique_lock lock(state_->mtx_);
+        if (node_.is_ready_.load(std::memory_order_relaxed)) {
+            registered_ = false;
+            return state_type::ready(sharded_unique_lock_guard(std::exchange(state_, nullptr)));
+        }
+        detail::rearm_waker(node_.waker_, w);
+        return state_type::pending();
+    }
+};
+
+/// Awaitable that acquires an upgradable lock on a `sharded_shared_mutex`.
+/// Returns a `sharded_upgradable_lock_guard` when the lock is acquired.
+class sharded_shared_mutex_upgradable_awaitable : public awaitable_always_blocks {
+    detail::sharded_shared_mutex_state* state_;
+    detail::sharded_waiter node_;
+    bool registered_{false};
+
+    void deregister() {
+        if (registered_ && state_) {
+            if (node_.is_ready_.load(std::memory_order_acquire) ||
+                !state_->remove_waiter(&node_)) {
+                // The lock was handed to us but never observed
+                state_->release_upgradable(node_.shard_);
+            }
+            registered_ = false;
+        }
+    }
+
+    using result_type = sharded_upgradable_lock_guard;
+    using state_type = awaitable_state<result_type>;
+
+  public:
+    explicit sharded_shared_mutex_upgradable_awaitable(detail::sharded_shared_mutex_state* state)
+        : state_(state) {}
+
+    sharded_shared_mutex_upgradable_awaitable(sharded_shared_mutex_upgradable_awaitable&& other
+    ) noexcept
+        : state_(std::exchange(other.state_, nullptr)),
+          registered_(std::exchange(other.registered_, false)) {
+        if (registered_) {
+            state_->relink_waiter(other.node_, node_);
+        }
+    }
+
+    sharded_shared_mutex_upgradable_awaitable&
+    operator=(sharded_shared_mutex_upgradable_awaitable&& other) noexcept {
+        if (this != &other) {
+            deregister();
+            state_ = std::exchange(other.state_, nullptr);
+            registered_ = std::exchange(other.registered_, false);
+            if (registered_) {
+                state_->relink_waiter(other.node_, node_);
+            }
+        }
+        return *this;
+    }
+
+    sharded_shared_mutex_upgradable_awaitable(const sharded_shared_mutex_upgradable_awaitable&) =
+        delete;
+    sharded_shared_mutex_upgradable_awaitable&
+    operator=(const sharded_shared_mutex_upgradable_awaitable&) = delete;
+
+    ~sharded_shared_mutex_upgradable_awaitable() {
+        deregister();
+    }
+
+    state_type poll(const waker& w) {
+        if (!registered_) {
+            // Only one task holds the upgradable lock at a time, so there is no
+            // per-shard fast path to take
+            auto shard = state_->local_shard();
+            std::unique_lock lock(state_->mtx_);
+            if (state_->lock_upgradable_locked(shard)) {
+                return state_type::ready(
+                    sharded_upgradable_lock_guard(std::exchange(state_, nullptr), shard)
+                );
+            }
+
+            node_.waker_ = w;
+            node_.kind_ = detail::shared_lock_kind::upgradable;
+            node_.shard_ = shard;
+            registered_ = true;
+            state_->push_waiter(&node_);
+            return state_type::pending();
+        }
+
+        // Fast check if the lock has been handed to us
+        if (node_.is_ready_.load(std::memory_order_acquire)) {
+            registered_ = false;
+            return state_type::ready(
+                sharded_upgradable_lock_guard(std::exchange(state_, nullptr), node_.shard_)
+            );
+        }
+
+        std::unique_lock lock(state_->mtx_);
+        if (node_.is_ready_.load(std::memory_order_relaxed)) {
+            registered_ = false;
+            return state_type::ready(
+                sharded_upgradable_lock_guard(std::exchange(state_, nullptr), node_.shard_)
+            );
+        }
+        detail::rearm_waker(node_.waker_, w);
+        return state_type::pending();
+    }
+};
+
+/// A reader-biased async shared mutex for read-heavy hot paths.
+///
+/// `shared_mutex` keeps its reader count in a single atomic, so under a heavy
+/// read load every acquisition bounces the same cache line between cores. This
+/// variant gives each thread one of several reader counters, each on its own
+/// cache line: an uncontended read lock touches only its own shard plus a
+/// read-mostly writer flag, so read acquisition scales with the number of
+/// cores.
+///
+/// The cost moves to writers, which raise the writer flag and then wait for
+/// every shard to drain. Like `shared_mutex`, scheduling is writer-preferring:
+/// once a writer is waiting, new readers queue behind it. Waiters are served
+/// in FIFO order and linked intrusively, so contended paths never allocate.
+///
+/// Upgradable locks, upgrades and downgrades work as on `shared_mutex`, so the
+/// two are interchangeable. Taking or releasing the upgradable lock always goes
+/// through the internal mutex, since only one task can hold it at a time.
+///
+/// Example:
+/// ```cpp
+/// pollcoro::sharded_shared_mutex routes_mtx;
+///
+/// task<void> lookup() {
+///     auto guard = co_await routes_mtx.lock_shared();
+///     // many readers, on many cores, without contending on one counter
+/// }
+///
+/// task<void> update() {
+///     auto guard = co_await routes_mtx.lock();
+///     // exclusive access
+/// }
+/// ```
+class sharded_shared_mutex {
+    detail::sharded_shared_mutex_state state_;
+
+  public:
+    /// Creates a mutex with `shards` reader counters, rounded up to a power of
+    /// two. Defaults to one per hardware thread, capped at 64.
+    explicit sharded_shared_mutex(
+        std::size_t shards = detail::sharded_shared_mutex_state::default_shard_count()
+    )
+        : state_(shards) {}
+
+    sharded_shared_mutex(const sharded_shared_mutex&) = delete;
+    sharded_shared_mutex& operator=(const sharded_shared_mutex&) = delete;
+
+    /// Returns an awaitable that acquires an exclusive (write) lock.
+    /// The returned awaitable yields a `sharded_unique_lock_guard` that
+    /// releases the lock when destroyed.
+    sharded_shared_mutex_write_awaitable lock() {
+        return sharded_shared_mutex_write_awaitable(&state_);
+    }
+
+    /// Returns an awaitable that acquires a shared (read) lock.
+    /// The returned awaitable yields a `sharded_shared_lock_guard` that
+    /// releases the lock when destroyed.
+    sharded_shared_mutex_read_awaitable lock_shared() {
+        return sharded_shared_mutex_read_awaitable(&state_);
+    }
+
+    /// Returns an awaitable that acquires an upgradable lock.
+    /// The returned awaitable yields a `sharded_upgradable_lock_guard` that
+    /// releases the lock when destroyed.
+    sharded_shared_mutex_upgradable_awaitable lock_upgradable() {
+        return sharded_shared_mutex_upgradable_awaitable(&state_);
+    }
+
+    /// Attempts to acquire an exclusive (write) lock immediately without
+    /// blocking. Returns a `sharded_unique_lock_guard` if successful, or
+    /// `std::nullopt` if the lock is currently held or contended.
+    std::optional<sharded_unique_lock_guard> try_lock() {
+        std::unique_lock lock(state_.mtx_);
+        if (state_.lock_locked()) {
+            return sharded_unique_lock_guard(&state_);
+        }
+        state_.cancel_writer_intent();
+        return std::nullopt;
+    }
+
+    /// Attempts to acquire a shared (read) lock immediately without blocking.
+    /// Returns a `sharded_shared_lock_guard` if successful, or `std::nullopt`
+    /// if a writer currently holds the lock or is waiting.
+    std::optional<sharded_shared_lock_guard> try_lock_shared() {
+        if (auto shard = state_.try_lock_shared_fast()) {
+            return sharded_shared_lock_guard(&state_, shard);
+        }
+
+        auto shard = state_.local_shard();
+        std::unique_lock lock(state_.mtx_);
+        if (state_.lock_shared_locked(shard)) {
+            return sharded_shared_lock_guard(&state_, shard);
+        }
+        return std::nullopt;
+    }
+
+    /// Attempts to acquire an upgradable lock immediately without blocking.
+    /// Returns a `sharded_upgradable_lock_guard` if successful, or
+    /// `std::nullopt` if a writer or another upgradable holder is active, or
+    /// anyone is waiting.
+    std::optional<sharded_upgradable_lock_guard> try_lock_upgradable() {
+        auto shard = state_.local_shard();
+        std::unique_lock lock(state_.mtx_);
+        if (state_.lock_upgradable_locked(shard)) {
+            return sharded_upgradable_lock_guard(&state_, shard);
+        }
+        return std::nullopt;
+    }
+
+    /// Returns the number of readers currently holding the lock. This sums
+    /// every shard, so it is only a snapshot and may be momentarily inflated by
+    /// readers backing out of a contended fast path.
+    std::size_t reader_count() const {
+        return state_.readers();
+    }
+
+    /// Check if a writer currently holds the lock.
+    bool is_writer_active() const {
+        std::lock_guard lock(state_.mtx_);
+        return state_.writer_held_;
+    }
+
+    /// Returns the number of reader shards.
+    std::size_t shard_count() const noexcept {
+        return state_.shard_count();
+    }
+};
+
+}  // namespace pollcoro
@@ -1,10 +1,8 @@
 module;
 
 #if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
-#include <algorithm>
 #include <atomic>
-#include <deque>
-#include <memory>
+#include <cstddef>
 #include <mutex>
 #include <optional>
 #include <utility>
@@ -18,6 +16,7 @@ import std;
 
 import :awaitable;
 import :is_blocking;
+import :waiter_list;
 import :waker;
 
 export namespace pollcoro {
@@ -25,69 +24,337 @@ export namespace pollcoro {
 class shared_mutex;
 class shared_lock_guard;
 class unique_lock_guard;
+class upgradable_lock_guard;
 class shared_mutex_read_awaitable;
 class shared_mutex_write_awaitable;
+class shared_mutex_upgradable_awaitable;
+class shared_mutex_upgrade_awaitable;
 
 namespace detail {
 
-struct shared_waiter {
-    waker waker_;
+enum class shared_lock_kind {
+    read,
+    write,
+    upgradable,
+    upgrade
+};
+
+struct shared_waiter : waiter_node {
     std::atomic<bool> is_ready_{false};
-    bool is_writer_{false};
+    shared_lock_kind kind_{shared_lock_kind::read};
+
+    // Waiters for exclusive access hold back new readers (writer preference)
+    bool wants_exclusive() const noexcept {
+        return kind_ == shared_lock_kind::write || kind_ == shared_lock_kind::upgrade;
+    }
 };
 
 struct shared_mutex_state {
+    static constexpr std::size_t writer_bit = 1;
+    static constexpr std::size_t waiters_bit = 2;
+    static constexpr std::size_t upgrader_bit = 4;
+    static constexpr std::size_t reader_one = 8;
+    // An upgradable lock counts as a reader and also owns `upgrader_bit`
+    static constexpr std::size_t upgradable_one = reader_one | upgrader_bit;
+
+    // Lock word: reader count in the upper bits, plus bits for an active
+    // writer, an upgradable holder and a non-empty waiter queue.
+    // `waiters_bit` only changes under `mtx_`. While it is clear, readers and
+    // writers acquire and release with a single atomic operation.
+    std::atomic<std::size_t> state_{0};
     mutable std::mutex mtx_;
-    std::size_t readers_{0};
-    bool writer_active_{false};
-    std::deque<std::shared_ptr<shared_waiter>> waiters_;
+    waiter_list waiters_;
+    std::size_t waiting_writers_{0};
+
+    static std::size_t readers(std::size_t s) noexcept {
+        return s / reader_one;
+    }
+
+    bool try_lock_shared_fast() noexcept {
+        auto s = state_.load(std::memory_order_relaxed);
+        while ((s & (writer_bit | waiters_bit)) == 0) {
+            if (state_.compare_exchange_weak(
+                    s, s + reader_one, std::memory_order_acquire, std::memory_order_relaxed
+                )) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool try_lock_upgradable_fast() noexcept {
+        auto s = state_.load(std::memory_order_relaxed);
+        while ((s & (writer_bit | upgrader_bit | waiters_bit)) == 0) {
+            if (state_.compare_exchange_weak(
+                    s, s + upgradable_one, std::memory_order_acquire, std::memory_order_relaxed
+                )) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool try_lock_fast() noexcept {
+        std::size_t expected = 0;
+        return state_.compare_exchange_strong(
+            expected, writer_bit, std::memory_order_acquire, std::memory_order_relaxed
+        );
+    }
+
+    // Only valid for the holder of the upgradable lock. Succeeds when it is
+    // the sole reader and nobody is queued.
+    bool try_upgrade_fast() noexcept {
+        std::size_t expected = upgradable_one;
+        return state_.compare_exchange_strong(
+            expected, writer_bit, std::memory_order_acquire, std::memory_order_relaxed
+        );
+    }
 
     void release_shared() {
-        std::unique_lock lock(mtx_);
-        --readers_;
-        if (readers_ == 0) {
+        auto s = state_.fetch_sub(reader_one, std::memory_order_release) - reader_one;
+        // The last reader leaving unblocks a queued writer, and the last reader
+        // besides the upgradable holder unblocks a pending upgrade
+        if ((s & waiters_bit) != 0 &&
+            (readers(s) == 0 || (readers(s) == 1 && (s & upgrader_bit) != 0))) {
+            std::unique_lock lock(mtx_);
+            wake_next(lock);
+        }
+    }
+
+    void release_upgradable() {
+        auto s = state_.fetch_sub(upgradable_one, std::memory_order_release) - upgradable_one;
+        if ((s & waiters_bit) != 0) {
+            std::unique_lock lock(mtx_);
             wake_next(lock);
         }
     }
 
     void release_exclusive() {
+        std::size_t expected = writer_bit;
+        if (state_.compare_exchange_strong(
+                expected, 0, std::memory_order_release, std::memory_order_relaxed
+            )) {
+            return;
+        }
+        std::unique_lock lock(mtx_);
+        state_.fetch_and(~writer_bit, std::memory_order_release);
+        wake_next(lock);
+    }
+
+    // Turns the exclusive lock into a shared one without letting a writer in.
+    void downgrade_exclusive() {
+        std::size_t expected = writer_bit;
+        if (state_.compare_exchange_strong(
+                expected, reader_one, std::memory_order_release, std::memory_order_relaxed
+            )) {
+            return;
+        }
+        std::unique_lock lock(mtx_);
+        // Clears `writer_bit` and adds a reader in one step
+        state_.fetch_add(reader_one - writer_bit, std::memory_order_release);
+        wake_next(lock);
+    }
+
+    // Turns the upgradable lock into a plain shared one.
+    void downgrade_upgradable() {
+        auto s = state_.fetch_and(~upgrader_bit, std::memory_order_release);
+        if ((s & waiters_bit) != 0) {
+            std::unique_lock lock(mtx_);
+            wake_next(lock);
+        }
+    }
+
+    // Must be called with `mtx_` held. Acquires a shared lock unless a writer
+    // holds the lock or is queued (writer preference); otherwise marks the lock
+    // as contended so the holder takes the slow release path.
+    bool lock_shared_or_mark_contended() noexcept {
+        auto s = state_.load(std::memory_order_relaxed);
+        while (true) {
+            if ((s & writer_bit) == 0 && waiting_writers_ == 0) {
+                if (state_.compare_exchange_weak(
+                        s, s + reader_one, std::memory_order_acquire, std::memory_order_relaxed
+                    )) {
+                    return true;
+                }
+            } else if (mark_contended(s)) {
+                return false;
+            }
+        }
+    }
+
+    // Must be called with `mtx_` held. Like `lock_shared_or_mark_contended`,
+    // but also waits for any other upgradable holder to leave.
+    bool lock_upgradable_or_mark_contended() noexcept {
+        auto s = state_.load(std::memory_order_relaxed);
+        while (true) {
+            if ((s & (writer_bit | upgrader_bit)) == 0 && waiting_writers_ == 0) {
+                if (state_.compare_exchange_weak(
+                        s, s + upgradable_one, std::memory_order_acquire, std::memory_order_relaxed
+                    )) {
+                    return true;
+                }
+            } else if (mark_contended(s)) {
+                return false;
+            }
+        }
+    }
+
+    // Must be called with `mtx_` held. Exclusive counterpart of
+    // `lock_shared_or_mark_contended`.
+    bool lock_or_mark_contended() noexcept {
+        auto s = state_.load(std::memory_order_relaxed);
+        while (true) {
+            if (s == 0) {
+                if (state_.compare_exchange_weak(
+                        s, writer_bit, std::memory_order_acquire, std::memory_order_relaxed
+                    )) {
+                    return true;
+                }
+            } else if (mark_contended(s)) {
+                return false;
+            }
+        }
+    }
+
+    // Must be called with `mtx_` held by the upgradable holder. Upgrades once
+    // every other reader has left; queued writers cannot get in first because
+    // the upgradable lock still counts as a reader.
+    bool upgrade_or_mark_contended() noexcept {
+        auto s = state_.load(std::memory_order_relaxed);
+        while (true) {
+            if (readers(s) == 1) {
+                if (state_.compare_exchange_weak(
+                        s,
+                        (s - upgradable_one) | writer_bit,
+                        std::memory_order_acquire,
+                        std::memory_order_relaxed
+                    )) {
+                    return true;
+                }
+            } else if (mark_contended(s)) {
+                return false;
+            }
+        }
+    }
+
+    // Must be called with `mtx_` held. A pending upgrade jumps the queue: it
+    // already holds part of the lock, and nothing behind it could proceed
+    // before it anyway.
+    void push_waiter(shared_waiter* waiter) {
+        if (waiter->kind_ == shared_lock_kind::upgrade) {
+            waiters_.push_front(waiter);
+        } else {
+            waiters_.push_back(waiter);
+        }
+        if (waiter->wants_exclusive()) {
+            ++waiting_writers_;
+        }
+    }
+
+    // O(1). Returns false if the waiter was no longer queued, meaning the lock
+    // has already been handed to it.
+    bool remove_waiter(shared_waiter* waiter) {
         std::unique_lock lock(mtx_);
-        writer_active_ = false;
+        if (!waiter->linked_) {
+            return false;
+        }
+        waiters_.remove(waiter);
+        if (waiter->wants_exclusive()) {
+            --waiting_writers_;
+        }
+        // Removing a queued writer may unblock the readers behind it
         wake_next(lock);
+        return true;
     }
 
-    void remove_waiter(const std::shared_ptr<shared_waiter>& waiter) {
+    // Moves a registered waiter's queue position and handoff state to the
+    // node of a move-constructed awaitable.
+    void relink_waiter(shared_waiter& from, shared_waiter& to) {
         std::unique_lock lock(mtx_);
-        auto it = std::find(waiters_.begin(), waiters_.end(), waiter);
-        if (it != waiters_.end()) {
-            waiters_.erase(it);
+        if (from.linked_) {
+            waiters_.replace(&from, &to);
         }
+        to.waker_ = from.waker_;
+        to.kind_ = from.kind_;
+        to.is_ready_.store(
+            from.is_ready_.load(std::memory_order_relaxed), std::memory_order_relaxed
+        );
     }
 
   private:
-    // Must be called with lock held. May unlock.
-    void wake_next(std::unique_lock<std::mutex>& lock) {
-        if (waiters_.empty()) {
-            return;
+    bool mark_contended(std::size_t& s) noexcept {
+        if ((s & waiters_bit) != 0) {
+            return true;
         }
+        return state_.compare_exchange_weak(
+            s, s | waiters_bit, std::memory_order_relaxed, std::memory_order_relaxed
+        );
+    }
 
-        // If front is a writer, wake it exclusively
-        if (waiters_.front()->is_writer_) {
-            auto next = std::move(waiters_.front());
-            waiters_.pop_front();
-            next->is_ready_ = true;
-            next->waker_.wake();
-            lock.unlock();
-            return;
+    static bool can_hand_off(shared_lock_kind kind, std::size_t s) noexcept {
+        switch (kind) {
+            case shared_lock_kind::read:
+                return true;
+            case shared_lock_kind::upgradable:
+                return (s & upgrader_bit) == 0;
+            case shared_lock_kind::write:
+                return readers(s) == 0;
+            case shared_lock_kind::upgrade:
+                return readers(s) == 1;
         }
+        return false;
+    }
 
-        // Front is a reader - wake all consecutive readers
-        while (!waiters_.empty() && !waiters_.front()->is_writer_) {
-            auto next = std::move(waiters_.front());
+    static std::size_t hand_off_delta(shared_lock_kind kind) noexcept {
+        switch (kind) {
+            case shared_lock_kind::read:
+                return reader_one;
+            case shared_lock_kind::upgradable:
+                return upgradable_one;
+            case shared_lock_kind::write:
+                return writer_bit;
+            case shared_lock_kind::upgrade:
+                // Trades the upgradable lock for `writer_bit` (wraps around)
+                return writer_bit - upgradable_one;
+        }
+        return 0;
+    }
+
+    // Must be called with `mtx_` held through `lock`, which it releases. Hands
+    // the lock directly to the waiters at the front of the queue until one of
+    // them cannot proceed: a run of readers is admitted together, while a
+    // writer or upgrade is admitted alone. Wakers are collected and invoked
+    // after unlocking, so a woken reader never contends on `mtx_` with the
+    // ones still being handed the lock.
+    void wake_next(std::unique_lock<std::mutex>& lock) {
+        wake_batch batch;
+        while (auto front = static_cast<shared_waiter*>(waiters_.front())) {
+            auto s = state_.load(std::memory_order_relaxed);
+            if ((s & writer_bit) != 0 || !can_hand_off(front->kind_, s)) {
+                break;
+            }
+            if (batch.full()) {
+                lock.unlock();
+                batch.wake_all();
+                lock.lock();
+                continue;
+            }
             waiters_.pop_front();
-            next->is_ready_.store(true, std::memory_order_release);
-            next->waker_.wake();
+            if (front->wants_exclusive()) {
+                --waiting_writers_;
+            }
+            state_.fetch_add(hand_off_delta(front->kind_), std::memory_order_relaxed);
+            // Copy the waker first: once `is_ready_` is set the waiter may
+            // complete without taking `mtx_` and free its node
+            batch.push(front->waker_);
+            front->is_ready_.store(true, std::memory_order_release);
         }
+
+        if (waiters_.empty()) {
+            state_.fetch_and(~waiters_bit, std::memory_order_relaxed);
+        }
+        lock.unlock();
+        batch.wake_all();
     }
 };
 
@@ -100,6 +367,8 @@ class shared_lock_guard {
 
     explicit shared_lock_guard(detail::shared_mutex_state* state) : state_(state) {}
 
+    friend class unique_lock_guard;
+    friend class upgradable_lock_guard;
     friend class shared_mutex_read_awaitable;
     friend class shared_mutex;
 
@@ -148,6 +417,7 @@ class unique_lock_guard {
     explicit unique_lock_guard(detail::shared_mutex_state* state) : state_(state) {}
 
     friend class shared_mutex_write_awaitable;
+    friend class shared_mutex_upgrade_awaitable;
     friend class shared_mutex;
 
   public:
@@ -181,6 +451,174 @@ class unique_lock_guard {
         }
     }
 
+    /// Atomically turns the exclusive lock into a shared one. No writer can
+    /// acquire the lock in between, and queued readers are admitted alongside
+    /// the returned guard. This guard no longer holds the lock afterwards.
+    shared_lock_guard downgrade() {
+        state_->downgrade_exclusive();
+        return shared_lock_guard(std::exchange(state_, nullptr));
+    }
+
+    /// Check if this guard still holds the lock.
+    explicit operator bool() const noexcept {
+        return state_ != nullptr;
+    }
+};
+
+/// Awaitable returned by `upgradable_lock_guard::upgrade()`. Holds the
+/// upgradable lock while pending and yields a `unique_lock_guard` once every
+/// other reader has released. Dropping it before completion releases the
+/// upgradable lock.
+class shared_mutex_upgrade_awaitable : public awaitable_always_blocks {
+    detail::shared_mutex_state* state_;
+    detail::shared_waiter node_;
+    bool registered_{false};
+
+    void release() {
+        if (!state_) {
+            return;
+        }
+        if (registered_) {
+            registered_ = false;
+            if (node_.is_ready_.load(std::memory_order_acquire) ||
+                !state_->remove_waiter(&node_)) {
+                // The upgrade went through but was never observed
+                state_->release_exclusive();
+                return;
+            }
+        }
+        state_->release_upgradable();
+    }
+
+    using result_type = unique_lock_guard;
+    using state_type = awaitable_state<result_type>;
+
+    friend class upgradable_lock_guard;
+
+    explicit shared_mutex_upgrade_awaitable(detail::shared_mutex_state* state) : state_(state) {}
+
+  public:
+    shared_mutex_upgrade_awaitable(shared_mutex_upgrade_awaitable&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)),
+          registered_(std::exchange(other.registered_, false)) {
+        if (registered_) {
+            state_->relink_waiter(other.node_, node_);
+        }
+    }
+
+    shared_mutex_upgrade_awaitable& operator=(shared_mutex_upgrade_awaitable&& other) noexcept {
+        if (this != &other) {
+            release();
+            state_ = std::exchange(other.state_, nullptr);
+            registered_ = std::exchange(other.registered_, false);
+            if (registered_) {
+                state_->relink_waiter(other.node_, node_);
+            }
+        }
+        return *this;
+    }
+
+    shared_mutex_upgrade_awaitable(const shared_mutex_upgrade_awaitable&) = delete;
+    shared_mutex_upgrade_awaitable& operator=(const shared_mutex_upgrade_awaitable&) = delete;
+
+    ~shared_mutex_upgrade_awaitable() {
+        release();
+    }
+
+    state_type poll(const waker& w) {
+        if (!registered_) {
+            // Lock-free fast path when we are the only reader
+            if (state_->try_upgrade_fast()) {
+                return state_type::ready(unique_lock_guard(std::exchange(state_, nullptr)));
+            }
+
+            std::unique_lock lock(state_->mtx_);
+            if (state_->upgrade_or_mark_contended()) {
+                return state_type::ready(unique_lock_guard(std::exchange(state_, nullptr)));
+            }
+
+            node_.waker_ = w;
+            node_.kind_ = detail::shared_lock_kind::upgrade;
+            registered_ = true;
+            state_->push_waiter(&node_);
+            return state_type::pending();
+        }
+
+        // Fast check if the upgrade has been granted
+        if (node_.is_ready_.load(std::memory_order_acquire)) {
+            registered_ = false;
+            return state_type::ready(unique_lock_guard(std::exchange(state_, nullptr)));
+        }
+
+        std::unique_lock lock(state_->mtx_);
+        if (node_.is_ready_.load(std::memory_order_relaxed)) {
+            registered_ = false;
+            return state_type::ready(unique_lock_guard(std::exchange(state_, nullptr)));
+        }
+        detail::rearm_waker(node_.waker_, w);
+        return state_type::pending();
+    }
+};
+
+/// RAII guard that holds an upgradable lock: a shared lock that coexists with
+/// plain readers but excludes writers and other upgradable holders, and can
+/// therefore be turned into an exclusive lock without being released first.
+/// The lock is released when the guard is destroyed or when `unlock()` is
+/// called explicitly.
+class upgradable_lock_guard {
+    detail::shared_mutex_state* state_;
+
+    explicit upgradable_lock_guard(detail::shared_mutex_state* state) : state_(state) {}
+
+    friend class shared_mutex_upgradable_awaitable;
+    friend class shared_mutex;
+
+  public:
+    upgradable_lock_guard(upgradable_lock_guard&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)) {}
+
+    upgradable_lock_guard& operator=(upgradable_lock_guard&& other) noexcept {
+        if (this != &other) {
+            if (state_) {
+                state_->release_upgradable();
+            }
+            state_ = std::exchange(other.state_, nullptr);
+        }
+        return *this;
+    }
+
+    upgradable_lock_guard(const upgradable_lock_guard&) = delete;
+    upgradable_lock_guard& operator=(const upgradable_lock_guard&) = delete;
+
+    ~upgradable_lock_guard() {
+        if (state_) {
+            state_->release_upgradable();
+        }
+    }
+
+    /// Explicitly release the lock before the guard is destroyed.
+    void unlock() {
+        if (state_) {
+            state_->release_upgradable();
+            state_ = nullptr;
+        }
+    }
+
+    /// Returns an awaitable that atomically upgrades to an exclusive lock once
+    /// the remaining readers have released theirs. New readers queue behind the
+    /// pending upgrade. Ownership moves into the awaitable, so this guard no
+    /// longer holds the lock afterwards.
+    shared_mutex_upgrade_awaitable upgrade() {
+        return shared_mutex_upgrade_awaitable(std::exchange(state_, nullptr));
+    }
+
+    /// Turns the upgradable lock into a plain shared lock, letting another task
+    /// take the upgradable lock. This guard no longer holds the lock afterwards.
+    shared_lock_guard downgrade() {
+        state_->downgrade_upgradable();
+        return shared_lock_guard(std::exchange(state_, nullptr));
+    }
+
     /// Check if this guard still holds the lock.
     explicit operator bool() const noexcept {
         return state_ != nullptr;
@@ -191,12 +629,16 @@ class unique_lock_guard {
 /// when the lock is acquired.
 class shared_mutex_read_awaitable : public awaitable_always_blocks {
     detail::shared_mutex_state* state_;
-    std::shared_ptr<detail::shared_waiter> waiter_;
+    detail::shared_waiter node_;
     bool registered_{false};
 
     void deregister() {
         if (registered_ && state_) {
-            state_->remove_waiter(waiter_);
+            if (node_.is_ready_.load(std::memory_order_acquire) ||
+                !state_->remove_waiter(&node_)) {
+                // The lock was handed to us but never observed
+                state_->release_shared();
+            }
             registered_ = false;
         }
     }
@@ -205,22 +647,24 @@ class shared_mutex_read_awaitable : public awaitable_always_blocks {
     using state_type = awaitable_state<result_type>;
 
   public:
-    explicit shared_mutex_read_awaitable(detail::shared_mutex_state* state)
-        : state_(state), waiter_(std::make_shared<detail::shared_waiter>()) {
-        waiter_->is_writer_ = false;
-    }
+    explicit shared_mutex_read_awaitable(detail::shared_mutex_state* state) : state_(state) {}
 
     shared_mutex_read_awaitable(shared_mutex_read_awaitable&& other) noexcept
         : state_(std::exchange(other.state_, nullptr)),
-          waiter_(std::move(other.waiter_)),
-          registered_(std::exchange(other.registered_, false)) {}
+          registered_(std::exchange(other.registered_, false)) {
+        if (registered_) {
+            state_->relink_waiter(other.node_, node_);
+        }
+    }
 
     shared_mutex_read_awaitable& operator=(shared_mutex_read_awaitable&& other) noexcept {
         if (this != &other) {
             deregister();
             state_ = std::exchange(other.state_, nullptr);
-            waiter_ = std::move(other.waiter_);
             registered_ = std::exchange(other.registered_, false);
+            if (registered_) {
+                state_->relink_waiter(other.node_, node_);
+            }
         }
         return *this;
     }
@@ -233,39 +677,37 @@ class shared_mutex_read_awaitable : public awaitable_always_blocks {
     }
 
     state_type poll(const waker& w) {
-        // Fast check if the waiter is ready
-        if (waiter_->is_ready_.load(std::memory_order_acquire)) {
-            return state_type::ready(shared_lock_guard(std::exchange(state_, nullptr)));
-        }
-
-        std::unique_lock lock(state_->mtx_);
-        waiter_->waker_ = w;
-
         if (!registered_) {
-            // Can acquire immediately if no writer active and no writers waiting
-            // (writer-preference to prevent writer starvation)
-            bool has_waiting_writer =
-                std::any_of(state_->waiters_.begin(), state_->waiters_.end(), [](const auto& w) {
-                    return w->is_writer_;
-                });
-
-            if (!state_->writer_active_ && !has_waiting_writer) {
-                ++state_->readers_;
+            // Lock-free fast path when no writer is active or waiting
+            if (state_->try_lock_shared_fast()) {
+                return state_type::ready(shared_lock_guard(std::exchange(state_, nullptr)));
+            }
+
+            std::unique_lock lock(state_->mtx_);
+            if (state_->lock_shared_or_mark_contended()) {
                 return state_type::ready(shared_lock_guard(std::exchange(state_, nullptr)));
             }
 
+            node_.waker_ = w;
+            node_.kind_ = detail::shared_lock_kind::read;
             registered_ = true;
-            state_->waiters_.push_back(waiter_);
+            state_->push_waiter(&node_);
             return state_type::pending();
         }
 
-        if (!waiter_->is_ready_) {
-            return state_type::pending();
+        // Fast check if the lock has been handed to us
+        if (node_.is_ready_.load(std::memory_order_acquire)) {
+            registered_ = false;
+            return state_type::ready(shared_lock_guard(std::exchange(state_, nullptr)));
         }
 
-        ++state_->readers_;
-        registered_ = false;
-        return state_type::ready(shared_lock_guard(state_));
+        std::unique_lock lock(state_->mtx_);
+        if (node_.is_ready_.load(std::memory_order_relaxed)) {
+            registered_ = false;
+            return state_type::ready(shared_lock_guard(std::exchange(state_, nullptr)));
+        }
+        detail::rearm_waker(node_.waker_, w);
+        return state_type::pending();
     }
 };
 
@@ -273,12 +715,16 @@ class shared_mutex_read_awaitable : public awaitable_always_blocks {
 /// `unique_lock_guard` when the lock is acquired.
 class shared_mutex_write_awaitable : public awaitable_always_blocks {
     detail::shared_mutex_state* state_;
-    std::shared_ptr<detail::shared_waiter> waiter_;
+    detail::shared_waiter node_;
     bool registered_{false};
 
     void deregister() {
         if (registered_ && state_) {
-            state_->remove_waiter(waiter_);
+            if (node_.is_ready_.load(std::memory_order_acquire) ||
+                !state_->remove_waiter(&node_)) {
+                // The lock was handed to us but never observed
+                state_->release_exclusive();
+            }
             registered_ = false;
         }
     }
@@ -287,22 +733,24 @@ class shared_mutex_write_awaitable : public awaitable_always_blocks {
     using state_type = awaitable_state<result_type>;
 
   public:
-    explicit shared_mutex_write_awaitable(detail::shared_mutex_state* state)
-        : state_(state), waiter_(std::make_shared<detail::shared_waiter>()) {
-        waiter_->is_writer_ = true;
-    }
+    explicit shared_mutex_write_awaitable(detail::shared_mutex_state* state) : state_(state) {}
 
     shared_mutex_write_awaitable(shared_mutex_write_awaitable&& other) noexcept
         : state_(std::exchange(other.state_, nullptr)),
-          waiter_(std::move(other.waiter_)),
-          registered_(std::exchange(other.registered_, false)) {}
+          registered_(std::exchange(other.registered_, false)) {
+        if (registered_) {
+            state_->relink_waiter(other.node_, node_);
+        }
+    }
 
     shared_mutex_write_awaitable& operator=(shared_mutex_write_awaitable&& other) noexcept {
         if (this != &other) {
             deregister();
             state_ = std::exchange(other.state_, nullptr);
-            waiter_ = std::move(other.waiter_);
             registered_ = std::exchange(other.registered_, false);
+            if (registered_) {
+                state_->relink_waiter(other.node_, node_);
+            }
         }
         return *this;
     }
@@ -315,32 +763,123 @@ class shared_mutex_write_awaitable : public awaitable_always_blocks {
     }
 
     state_type poll(const waker& w) {
-        // Fast check if the waiter is ready
-        if (waiter_->is_ready_.load(std::memory_order_acquire)) {
+        if (!registered_) {
+            if (state_->try_lock_fast()) {
+                return state_type::ready(unique_lock_guard(std::exchange(state_, nullptr)));
+            }
+
+            std::unique_lock lock(state_->mtx_);
+            if (state_->lock_or_mark_contended()) {
+                return state_type::ready(unique_lock_guard(std::exchange(state_, nullptr)));
+            }
+
+            node_.waker_ = w;
+            node_.kind_ = detail::shared_lock_kind::write;
+            registered_ = true;
+            state_->push_waiter(&node_);
+            return state_type::pending();
+        }
+
+        // Fast check if the lock has been handed to us
+        if (node_.is_ready_.load(std::memory_order_acquire)) {
+            registered_ = false;
             return state_type::ready(unique_lock_guard(std::exchange(state_, nullptr)));
         }
 
         std::unique_lock lock(state_->mtx_);
-        waiter_->waker_ = w;
+        if (node_.is_ready_.load(std::memory_order_relaxed)) {
+            registered_ = false;
+            return state_type::ready(unique_lock_guard(std::exchange(state_, nullptr)));
+        }
+        detail::rearm_waker(node_.waker_, w);
+        return state_type::pending();
+    }
+};
 
+/// Awaitable that acquires an upgradable lock. Returns an
+/// `upgradable_lock_guard` when the lock is acquired.
+class shared_mutex_upgradable_awaitable : public awaitable_always_blocks {
+    detail::shared_mutex_state* state_;
+    detail::shared_waiter node_;
+    bool registered_{false};
+
+    void deregister() {
+        if (registered_ && state_) {
+            if (node_.is_ready_.load(std::memory_order_acquire) ||
+                !state_->remove_waiter(&node_)) {
+                // The lock was handed to us but never observed
+                state_->release_upgradable();
+            }
+            registered_ = false;
+        }
+    }
+
+    using result_type = upgradable_lock_guard;
+    using state_type = awaitable_state<result_type>;
+
+  public:
+    explicit shared_mutex_upgradable_awaitable(detail::shared_mutex_state* state) : state_(state) {}
+
+    shared_mutex_upgradable_awaitable(shared_mutex_upgradable_awaitable&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)),
+          registered_(std::exchange(other.registered_, false)) {
+        if (registered_) {
+            state_->relink_waiter(other.node_, node_);
+        }
+    }
+
+    shared_mutex_upgradable_awaitable& operator=(shared_mutex_upgradable_awaitable&& other
+    ) noexcept {
+        if (this != &other) {
+            deregister();
+            state_ = std::exchange(other.state_, nullptr);
+            registered_ = std::exchange(other.registered_, false);
+            if (registered_) {
+                state_->relink_waiter(other.node_, node_);
+            }
+        }
+        return *this;
+    }
+
+    shared_mutex_upgradable_awaitable(const shared_mutex_upgradable_awaitable&) = delete;
+    shared_mutex_upgradable_awaitable& operator=(const shared_mutex_upgradable_awaitable&) = delete;
+
+    ~shared_mutex_upgradable_awaitable() {
+        deregister();
+    }
+
+    state_type poll(const waker& w) {
         if (!registered_) {
-            if (!state_->writer_active_ && state_->readers_ == 0) {
-                state_->writer_active_ = true;
-                return state_type::ready(unique_lock_guard(std::exchange(state_, nullptr)));
+            // Lock-free fast path when no writer or upgradable holder is active
+            if (state_->try_lock_upgradable_fast()) {
+                return state_type::ready(upgradable_lock_guard(std::exchange(state_, nullptr)));
+            }
+
+            std::unique_lock lock(state_->mtx_);
+            if (state_->lock_upgradable_or_mark_contended()) {
+                return state_type::ready(upgradable_lock_guard(std::exchange(state_, nullptr)));
             }
 
+            node_.waker_ = w;
+            node_.kind_ = detail::shared_lock_kind::upgradable;
             registered_ = true;
-            state_->waiters_.push_back(waiter_);
+            state_->push_waiter(&node_);
             return state_type::pending();
         }
 
-        if (!waiter_->is_ready_) {
-            return state_type::pending();
+        // Fast check if the lock has been handed to us
+        if (node_.is_ready_.load(std::memory_order_acquire)) {
+            registered_ = false;
+            return state_type::ready(upgradable_lock_guard(std::exchange(state_, nullptr)));
         }
 
-        state_->writer_active_ = true;
-        registered_ = false;
-        return state_type::ready(unique_lock_guard(std::exchange(state_, nullptr)));
+        std::unique_lock lock(state_->mtx_);
+        if (node_.is_ready_.load(std::memory_order_relaxed)) {
+            registered_ = false;
+            return state_type::ready(upgradable_lock_guard(std::exchange(state_, nullptr)));
+        }
+        detail::rearm_waker(node_.waker_, w);
+        return state_type::pending();
     }
 };
 
@@ -348,7 +887,13 @@ class shared_mutex_write_awaitable : public awaitable_always_blocks {
 ///
 /// This mutex allows multiple concurrent readers or a single exclusive writer.
 /// It uses writer-preference scheduling to prevent writer starvation: when a
-/// writer is waiting, new readers will queue behind it.
+/// writer is waiting, new readers will queue behind it. Waiter nodes live inside
+/// the lock awaitables, so even contended acquisitions never allocate.
+///
+/// An upgradable lock is a shared lock that at most one task can hold at a
+/// time. It coexists with plain readers, and can later be upgraded to an
+/// exclusive lock without releasing it first, so a read-mostly path that only
+/// sometimes needs to write does not have to redo its lookup.
 ///
 /// Example:
 /// ```cpp
@@ -365,6 +910,14 @@ class shared_mutex_write_awaitable : public awaitable_always_blocks {
 ///     // exclusive access - no other readers or writers
 ///     co_await some_async_write();
 /// }
+///
+/// task<void> refresher() {
+///     auto guard = co_await mtx.lock_upgradable();
+///     if (is_stale()) {
+///         auto writer = co_await guard.upgrade();
+///         co_await refresh();
+///     }
+/// }
 /// ```
 class shared_mutex {
     detail::shared_mutex_state state_;
@@ -386,13 +939,18 @@ class shared_mutex {
         return shared_mutex_read_awaitable(&state_);
     }
 
+    /// Returns an awaitable that acquires an upgradable lock.
+    /// The returned awaitable yields an `upgradable_lock_guard` that releases
+    /// the lock when destroyed.
+    shared_mutex_upgradable_awaitable lock_upgradable() {
+        return shared_mutex_upgradable_awaitable(&state_);
+    }
+
     /// Attempts to acquire an exclusive (write) lock immediately without
     /// blocking. Returns a `unique_lock_guard` if successful, or `std::nullopt`
     /// if the lock is currently held.
     std::optional<unique_lock_guard> try_lock() {
-        std::unique_lock lock(state_.mtx_);
-        if (!state_.writer_active_ && state_.readers_ == 0) {
-            state_.writer_active_ = true;
+        if (state_.try_lock_fast()) {
             return unique_lock_guard(&state_);
         }
         return std::nullopt;
@@ -402,29 +960,60 @@ class shared_mutex {
     /// Returns a `shared_lock_guard` if successful, or `std::nullopt` if a
     /// writer currently holds the lock or is waiting.
     std::optional<shared_lock_guard> try_lock_shared() {
+        if (state_.try_lock_shared_fast()) {
+            return shared_lock_guard(&state_);
+        }
+
         std::unique_lock lock(state_.mtx_);
-        bool has_waiting_writer =
-            std::any_of(state_.waiters_.begin(), state_.waiters_.end(), [](const auto& w) {
-                return w->is_writer_;
-            });
+        auto s = state_.state_.load(std::memory_order_relaxed);
+        while ((s & detail::shared_mutex_state::writer_bit) == 0 && state_.waiting_writers_ == 0) {
+            if (state_.state_.compare_exchange_weak(
+                    s,
+                    s + detail::shared_mutex_state::reader_one,
+                    std::memory_order_acquire,
+                    std::memory_order_relaxed
+                )) {
+                return shared_lock_guard(&state_);
+            }
+        }
+        return std::nullopt;
+    }
 
-        if (!state_.writer_active_ && !has_waiting_writer) {
-            ++state_.readers_;
-            return shared_lock_guard(&state_);
+    /// Attempts to acquire an upgradable lock immediately without blocking.
+    /// Returns an `upgradable_lock_guard` if successful, or `std::nullopt` if a
+    /// writer or another upgradable holder is active, or a writer is waiting.
+    std::optional<upgradable_lock_guard> try_lock_upgradable() {
+        if (state_.try_lock_upgradable_fast()) {
+            return upgradable_lock_guard(&state_);
+        }
+
+        std::unique_lock lock(state_.mtx_);
+        constexpr auto blocked =
+            detail::shared_mutex_state::writer_bit | detail::shared_mutex_state::upgrader_bit;
+        auto s = state_.state_.load(std::memory_order_relaxed);
+        while ((s & blocked) == 0 && state_.waiting_writers_ == 0) {
+            if (state_.state_.compare_exchange_weak(
+                    s,
+                    s + detail::shared_mutex_state::upgradable_one,
+                    std::memory_order_acquire,
+                    std::memory_order_relaxed
+                )) {
+                return upgradable_lock_guard(&state_);
+            }
         }
         return std::nullopt;
     }
 
-    /// Returns the number of readers currently holding the lock.
+    /// Returns the number of readers currently holding the lock, including an
+    /// upgradable holder.
     std::size_t reader_count() const {
-        std::unique_lock lock(state_.mtx_);
-        return state_.readers_;
+        return detail::shared_mutex_state::readers(state_.state_.load(std::memory_order_relaxed));
     }
 
     /// Check if a writer currently holds the lock.
     bool is_writer_active() const {
-        std::unique_lock lock(state_.mtx_);
-        return state_.writer_active_;
+        return (state_.state_.load(std::memory_order_relaxed) &
+                detail::shared_mutex_state::writer_bit) != 0;
     }
 };
 
@@ -52,18 +52,21 @@ class single_event_awaitable : public awaitable_always_blocks {
 
         std::mutex mutex_;
         bool ready_{false};
+        bool waiting_{false};  // A waker has been stored
         waker waker_;
 
       public:
         void set_waker(const waker& new_waker) {
             std::unique_lock lock(mutex_);
-            if (!waker_.will_wake(new_waker)) {
-                if (ready_) {
+            if (ready_) {
+                if (!waker_.will_wake(new_waker)) {
                     lock.unlock();
                     new_waker.wake();
-                } else {
-                    waker_ = new_waker;
                 }
+            } else if (std::exchange(waiting_, true)) {
+                detail::rearm_waker(waker_, new_waker);
+            } else {
+                waker_ = new_waker;
             }
         }
 
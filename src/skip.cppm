@@ -12,6 +12,7 @@ export module pollcoro:skip;
 import std;
 #endif
 
+import :budget;
 import :is_blocking;
 import :stream_awaitable;
 import :waker;
@@ -42,6 +43,9 @@ class skip_stream_awaitable : public awaitable_maybe_blocks<StreamAwaitable> {
 
             if (state.is_ready()) {
                 count_--;
+                if (!consume_budget(w)) {
+                    return state_type::pending();
+                }
                 continue;
             }
 
@@ -13,6 +13,7 @@ export module pollcoro:skip_while;
 import std;
 #endif
 
+import :budget;
 import :is_blocking;
 import :stream_awaitable;
 import :waker;
@@ -50,6 +51,9 @@ class skip_while_stream_awaitable : public awaitable_maybe_blocks<StreamAwaitabl
                 auto result = state.take_result();
                 skipping_ = std::invoke(predicate_, result);
                 if (skipping_) {
+                    if (!consume_budget(w)) {
+                        return state_type::pending();
+                    }
                     continue;
                 }
                 return state_type::ready(std::move(result));
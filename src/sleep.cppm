@@ -16,7 +16,9 @@ import std;
 #endif
 
 import :awaitable;
+import :cancellation;
 import :is_blocking;
+import :trace;
 import :waker;
 
 export namespace pollcoro {
@@ -46,8 +48,12 @@ class sleep_awaitable : public awaitable_always_blocks {
     bool started_ = false;
     Timer timer_;
     typename Timer::time_point deadline_;
+    cancellation_registration cancellation_;
+    [[no_unique_address]] detail::trace_span span_;  // From the first poll, for tracing
 
     void reset() {
+        cancellation_.reset();
+        span_.end();
         if (shared_ && started_) {
             std::lock_guard lock(shared_->mutex);
             shared_->waker = pollcoro::waker();
@@ -75,6 +81,8 @@ class sleep_awaitable : public awaitable_always_blocks {
         started_ = other.started_;
         deadline_ = other.deadline_;
         timer_ = std::move(other.timer_);
+        cancellation_ = std::move(other.cancellation_);
+        span_ = std::move(other.span_);
         other.shared_ = nullptr;
         other.started_ = false;
     }
@@ -86,6 +94,8 @@ class sleep_awaitable : public awaitable_always_blocks {
             started_ = other.started_;
             deadline_ = other.deadline_;
             timer_ = std::move(other.timer_);
+            cancellation_ = std::move(other.cancellation_);
+            span_ = std::move(other.span_);
             other.shared_ = nullptr;
             other.started_ = false;
         }
@@ -94,13 +104,26 @@ class sleep_awaitable : public awaitable_always_blocks {
 
     awaitable_state<> poll(const waker& w) {
         if (timer_.now() >= deadline_) {
+            cancellation_.reset();
+            span_.end();
             return awaitable_state<>::ready();
         }
 
+        // The timer cannot be unregistered, but its callback becomes a no-op
+        auto token = current_cancellation_token();
+        if (token.is_cancellation_requested()) {
+            reset();
+            throw operation_cancelled();
+        }
+        cancellation_.reset(token, w);
+
         std::lock_guard lock(shared_->mutex);
-        shared_->waker = w;
-        if (!started_) {
+        if (started_) {
+            detail::rearm_waker(shared_->waker, w);
+        } else {
+            shared_->waker = w;
             started_ = true;
+            span_.begin("sleep", "sleep");
             timer_.register_callback(deadline_, [shared = shared_]() {
                 std::lock_guard lock(shared->mutex);
                 shared->waker.wake();
@@ -2,7 +2,6 @@ module;
 
 #if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
 #include <coroutine>
-#include <exception>
 #include <utility>
 #endif
 
@@ -12,7 +11,9 @@ export module pollcoro:stream;
 import std;
 #endif
 
+import :budget;
 import :detail_promise;
+import :instrument;
 import :is_blocking;
 import :stream_awaitable;
 import :waker;
@@ -60,32 +61,29 @@ class stream : public awaitable_always_blocks {
 
     stream_awaitable_state<T> poll_next(const waker& w) {
         auto& promise = handle_.promise();
-        bool resumed = false;
-        if (!is_ready()) {
-            try {
-                resumed = promise.poll_ready(w);
-            } catch (...) {
-                promise.exception = std::current_exception();
-                resumed = true;
+        auto traced = detail::trace_begin();
+        // Resume until the coroutine yields, finishes or waits on something
+        // that is genuinely pending. A yielded-from stream hands its items over
+        // without resuming the coroutine.
+        for (bool resumed = false; !promise.has_value() && !is_ready(); resumed = true) {
+            if (resumed && !consume_budget(w)) {
+                detail::instrument_poll(handle_.address(), poll_site::stream, false);
+                promise.trace_poll("stream::poll_next", traced, false);
+                return stream_awaitable_state<T>::pending();
             }
-            if (resumed) {
-                handle_.resume();
+            if (!promise.poll_ready(w) && !promise.has_value()) {
+                detail::instrument_poll(handle_.address(), poll_site::stream, false);
+                promise.trace_poll("stream::poll_next", traced, false);
+                return stream_awaitable_state<T>::pending();
             }
         }
+        detail::instrument_poll(handle_.address(), poll_site::stream, true);
+        promise.trace_poll("stream::poll_next", traced, true);
 
         if (promise.has_value()) {
             return stream_awaitable_state<T>::ready(promise.take_result());
         }
-
-        if (is_ready()) {
-            return stream_awaitable_state<T>::done();
-        }
-
-        if (resumed) {
-            w.wake();
-        }
-
-        return stream_awaitable_state<T>::pending();
+        return stream_awaitable_state<T>::done();
     }
 
   private:
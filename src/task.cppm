@@ -14,8 +14,11 @@ import std;
 #endif
 
 import :awaitable;
+import :budget;
 import :detail_promise;
+import :instrument;
 import :is_blocking;
+import :trace;
 import :waker;
 
 export namespace pollcoro {
@@ -60,37 +63,34 @@ class task : public awaitable_always_blocks {
 
     awaitable_state<T> poll(const waker& w) {
         auto& promise = handle_.promise();
-        bool resumed = false;
-        if (!is_ready()) {
-            try {
-                resumed = promise.poll_ready(w);
-            } catch (...) {
-                promise.exception = std::current_exception();
-                resumed = true;
+        auto traced = detail::trace_begin();
+        // Resume for as long as the awaited leaf is ready, so a suspension that
+        // completes synchronously never goes back through the executor.
+        for (bool resumed = false; !is_ready(); resumed = true) {
+            if (resumed && !consume_budget(w)) {
+                detail::instrument_poll(handle_.address(), poll_site::task, false);
+                promise.trace_poll("task::poll", traced, false);
+                return awaitable_state<T>::pending();
             }
-            if (resumed) {
-                handle_.resume();
+            if (!promise.poll_ready(w)) {
+                detail::instrument_poll(handle_.address(), poll_site::task, false);
+                promise.trace_poll("task::poll", traced, false);
+                return awaitable_state<T>::pending();
             }
         }
+        detail::instrument_poll(handle_.address(), poll_site::task, true);
+        promise.trace_poll("task::poll", traced, true);
 
-        if (is_ready()) {
-            auto exception = promise.exception;
-            promise.exception = nullptr;
-            if (exception) {
-                std::rethrow_exception(exception);
-            }
-            if constexpr (std::is_void_v<T>) {
-                return awaitable_state<T>::ready();
-            } else {
-                return awaitable_state<T>::ready(promise.take_result());
-            }
+        auto exception = promise.exception;
+        promise.exception = nullptr;
+        if (exception) {
+            std::rethrow_exception(exception);
         }
-
-        if (resumed) {
-            w.wake();
+        if constexpr (std::is_void_v<T>) {
+            return awaitable_state<T>::ready();
+        } else {
+            return awaitable_state<T>::ready(promise.take_result());
         }
-
-        return awaitable_state<T>::pending();
     }
 
     // The task will be left in an empty state after this call.
@@ -100,6 +100,8 @@ class task : public awaitable_always_blocks {
     }
 
   private:
+    friend struct detail::task_access;
+
     std::coroutine_handle<promise_type> handle_;
     bool destroy_on_drop_{true};
 
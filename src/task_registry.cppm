@@ -0,0 +1,321 @@
+module;
+
+#if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <source_location>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#endif
+
+export module pollcoro:task_registry;
+
+#if defined(POLLCORO_IMPORT_STD) && POLLCORO_IMPORT_STD == 1
+import std;
+#endif
+
+export namespace pollcoro {
+
+/// True when pollcoro is built with `POLLCORO_TASK_REGISTRY=1` (the
+/// `POLLCORO_TASK_REGISTRY` CMake option). Every live task and stream frame is
+/// then recorded for `dump_tasks()`; otherwise the registry compiles away.
+#if defined(POLLCORO_TASK_REGISTRY) && POLLCORO_TASK_REGISTRY == 1
+inline constexpr bool task_registry_enabled = true;
+#else
+inline constexpr bool task_registry_enabled = false;
+#endif
+
+namespace detail {
+
+enum class frame_state : unsigned char {
+    created,    // Not polled yet
+    running,    // Being resumed, or polling what it awaits
+    suspended,  // Waiting for what it awaits to wake it
+    done,       // Finished, not destroyed yet
+};
+
+// Expands to a signature naming `T`, from which `awaited_type_name` extracts
+// the type. Resolved at compile time, so only a pointer is stored per await.
+template<typename T>
+constexpr const char* type_signature() noexcept {
+    return std::source_location::current().function_name();
+}
+
+inline std::string_view awaited_type_name(std::string_view signature) noexcept {
+    // GCC: "... [with T = X]", Clang: "... [T = X]", MSVC: "...type_signature<X>(void)"
+    if (auto begin = signature.find("T = "); begin != std::string_view::npos) {
+        begin += 4;
+        auto end = signature.find_first_of(";]", begin);
+        return signature.substr(begin, end - begin);
+    }
+    if (auto begin = signature.find("type_signature<"); begin != std::string_view::npos) {
+        begin += 15;
+        return signature.substr(begin, signature.rfind(">(") - begin);
+    }
+    return signature;
+}
+
+// Debug record embedded in every task and stream promise. Fields other than
+// the list links are read by `dump_tasks()` from another thread while the
+// frame runs, so they are relaxed atomics; the picture is a best-effort
+// snapshot rather than a consistent cut.
+struct frame_record {
+    std::source_location location_;
+    frame_record* prev_ = nullptr;  // Guarded by the registry mutex
+    frame_record* next_ = nullptr;  // Guarded by the registry mutex
+    // The frame awaiting this one if fused into it, else the frame whose
+    // poll last polled this one
+    std::atomic<const frame_record*> parent_{nullptr};
+    std::atomic<const char*> awaiting_{nullptr};  // `type_signature` of the awaitable
+    std::atomic<frame_state> state_{frame_state::created};
+};
+
+struct empty_frame_record {};
+
+using frame_record_t =
+    std::conditional_t<task_registry_enabled, frame_record, empty_frame_record>;
+
+class task_registry {
+    std::mutex mtx_;
+    frame_record* head_ = nullptr;
+
+  public:
+    void add(frame_record* record) {
+        std::lock_guard lock(mtx_);
+        record->next_ = head_;
+        if (head_) {
+            head_->prev_ = record;
+        }
+        head_ = record;
+    }
+
+    void remove(frame_record* record) {
+        std::lock_guard lock(mtx_);
+        if (record->prev_) {
+            record->prev_->next_ = record->next_;
+        } else {
+            head_ = record->next_;
+        }
+        if (record->next_) {
+            record->next_->prev_ = record->prev_;
+        }
+    }
+
+    template<typename Func>
+    void for_each(Func&& func) {
+        std::lock_guard lock(mtx_);
+        for (auto record = head_; record; record = record->next_) {
+            func(*record);
+        }
+    }
+};
+
+inline task_registry& global_task_registry() {
+    static task_registry registry;
+    return registry;
+}
+
+// Frame whose awaited awaitable is being polled on this thread
+inline thread_local const frame_record* current_polling_frame = nullptr;
+
+// The hooks below are templates so that, with the registry disabled, their
+// bodies are discarded rather than checked against `empty_frame_record`.
+
+template<typename Record>
+void register_frame(Record& record, const std::source_location& location) {
+    if constexpr (task_registry_enabled) {
+        record.location_ = location;
+        global_task_registry().add(&record);
+    }
+}
+
+template<typename Record>
+void unregister_frame(Record& record) {
+    if constexpr (task_registry_enabled) {
+        global_task_registry().remove(&record);
+    }
+}
+
+template<typename Record>
+void set_frame_state(Record& record, frame_state state) noexcept {
+    if constexpr (task_registry_enabled) {
+        record.state_.store(state, std::memory_order_relaxed);
+    }
+}
+
+template<typename Awaitable, typename Record>
+void set_frame_awaiting(Record& record) noexcept {
+    if constexpr (task_registry_enabled) {
+        record.awaiting_.store(type_signature<Awaitable>(), std::memory_order_relaxed);
+    }
+}
+
+template<typename Record>
+void clear_frame_awaiting(Record& record) noexcept {
+    if constexpr (task_registry_enabled) {
+        record.awaiting_.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+template<typename Record>
+void set_frame_parent(Record& record, const Record* parent) noexcept {
+    if constexpr (task_registry_enabled) {
+        record.parent_.store(parent, std::memory_order_relaxed);
+    }
+}
+
+// Marks a root frame as polled by whichever frame is polling on this thread.
+template<typename Record>
+void note_frame_polled(Record& record) noexcept {
+    if constexpr (task_registry_enabled) {
+        if (current_polling_frame) {
+            record.parent_.store(current_polling_frame, std::memory_order_relaxed);
+        }
+    }
+}
+
+// Makes `record` the frame polling on this thread while its awaitable is
+// polled, so that tasks polled from inside it are shown beneath it.
+class frame_poll_scope {
+    const frame_record* saved_ = nullptr;
+
+  public:
+    template<typename Record>
+    explicit frame_poll_scope(const Record& record) noexcept {
+        if constexpr (task_registry_enabled) {
+            saved_ = std::exchange(current_polling_frame, &record);
+        }
+    }
+
+    frame_poll_scope(const frame_poll_scope&) = delete;
+    frame_poll_scope& operator=(const frame_poll_scope&) = delete;
+
+    ~frame_poll_scope() {
+        if constexpr (task_registry_enabled) {
+            current_polling_frame = saved_;
+        }
+    }
+};
+
+}  // namespace detail
+
+/// Prints every live task and stream as a tree to `out`: each frame with the
+/// coroutine it runs and where that is defined, its state, and what it is
+/// awaiting. Frames appear beneath the frame awaiting them, or beneath the
+/// frame that last polled them when driven through a combinator such as
+/// `wait_all`, so a stalled service shows which leaf every chain is stuck on.
+///
+/// Requires `POLLCORO_TASK_REGISTRY=1`. Safe to call from any thread, for
+/// example a signal-triggered diagnostics thread, while tasks run; the output
+/// is a best-effort snapshot.
+///
+/// Example output:
+/// ```
+/// pollcoro::task<void> serve() at server.cc:42 [suspended]
+///   pollcoro::task<int> handle(connection) at server.cc:17 [suspended]
+///     awaiting pollcoro::sleep_awaitable<pollcoro::timer>
+/// ```
+inline void dump_tasks(std::FILE* out = stderr) {
+    if constexpr (!task_registry_enabled) {
+        std::fprintf(
+            out, "pollcoro: task registry disabled (build with POLLCORO_TASK_REGISTRY=1)\n"
+        );
+    } else {
+        struct entry {
+            const detail::frame_record* record;
+            const detail::frame_record* parent;
+            std::source_location location;
+            const char* awaiting;
+            detail::frame_state state;
+        };
+
+        std::vector<entry> entries;
+        std::unordered_map<const detail::frame_record*, std::size_t> index;
+        detail::global_task_registry().for_each([&](const detail::frame_record& record) {
+            index.emplace(&record, entries.size());
+            entries.push_back(
+                {&record,
+                 record.parent_.load(std::memory_order_relaxed),
+                 record.location_,
+                 record.awaiting_.load(std::memory_order_relaxed),
+                 record.state_.load(std::memory_order_relaxed)}
+            );
+        });
+
+        // Frames whose parent is gone or unknown are roots
+        std::unordered_map<const detail::frame_record*, std::vector<std::size_t>> children;
+        std::vector<std::size_t> roots;
+        for (std::size_t i = entries.size(); i-- > 0;) {
+            auto parent = entries[i].parent;
+            if (parent && parent != entries[i].record && index.contains(parent)) {
+                children[parent].push_back(i);
+            } else {
+                roots.push_back(i);
+            }
+        }
+
+        static constexpr const char* state_names[] = {"created", "running", "suspended", "done"};
+        std::vector<std::pair<std::size_t, int>> stack;
+        for (auto it = roots.rbegin(); it != roots.rend(); ++it) {
+            stack.emplace_back(*it, 0);
+        }
+        std::vector<bool> printed(entries.size());
+        std::fprintf(out, "pollcoro: %zu live frames\n", entries.size());
+        while (!stack.empty()) {
+            auto [i, depth] = stack.back();
+            stack.pop_back();
+            if (printed[i]) {
+                continue;
+            }
+            printed[i] = true;
+
+            auto& e = entries[i];
+            std::fprintf(
+                out,
+                "%*s%s at %s:%u [%s]\n",
+                depth * 2,
+                "",
+                e.location.function_name(),
+                e.location.file_name(),
+                static_cast<unsigned>(e.location.line()),
+                state_names[static_cast<int>(e.state)]
+            );
+            if (e.awaiting) {
+                auto name = detail::awaited_type_name(e.awaiting);
+                std::fprintf(
+                    out,
+                    "%*sawaiting %.*s\n",
+                    depth * 2 + 2,
+                    "",
+                    static_cast<int>(name.size()),
+                    name.data()
+                );
+            }
+            if (auto found = children.find(e.record); found != children.end()) {
+                for (auto child = found->second.rbegin(); child != found->second.rend(); ++child) {
+                    stack.emplace_back(*child, depth + 1);
+                }
+            }
+        }
+        // Parent cycles, possible in a racy snapshot, are printed flat
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            if (!printed[i]) {
+                auto& e = entries[i];
+                std::fprintf(
+                    out,
+                    "%s at %s:%u\n",
+                    e.location.function_name(),
+                    e.location.file_name(),
+                    static_cast<unsigned>(e.location.line())
+                );
+            }
+        }
+        std::fflush(out);
+    }
+}
+
+}  // namespace pollcoro
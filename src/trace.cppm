@@ -0,0 +1,428 @@
+module;
+
+#if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#endif
+
+export module pollcoro:trace;
+
+#if defined(POLLCORO_IMPORT_STD) && POLLCORO_IMPORT_STD == 1
+import std;
+#endif
+
+export namespace pollcoro {
+
+/// True when pollcoro is built with `POLLCORO_TRACE=1` (the `POLLCORO_TRACE`
+/// CMake option). Otherwise every trace point is compiled out and
+/// `start_tracing` has no effect.
+#if defined(POLLCORO_TRACE) && POLLCORO_TRACE == 1
+inline constexpr bool tracing_enabled = true;
+#else
+inline constexpr bool tracing_enabled = false;
+#endif
+
+namespace detail {
+
+// A Chrome trace event. Names and categories must be string literals or
+// otherwise outlive the trace, as only the pointers are recorded.
+struct trace_event {
+    const char* name;
+    const char* cat;
+    std::uint64_t id;  // Frame or span id, or flow id
+    std::int64_t ts;   // Nanoseconds since the trace epoch
+    std::int64_t dur;  // For complete events
+    char phase;        // 'X' complete, 'b'/'e' async span, 's'/'f' flow
+    signed char ready; // For polls: 1 ready, 0 pending, -1 not a poll
+};
+
+// One entry of a `trace_buffer`, written as a seqlock so that `drain` can copy
+// it while the owning thread overwrites it. `seq_` is odd while event `n` is
+// being written and `2 * n + 2` once it is complete; the fields are relaxed
+// atomics, which compile to plain loads and stores.
+class trace_slot {
+    std::atomic<std::uint64_t> seq_{0};
+    std::atomic<const char*> name_{nullptr};
+    std::atomic<const char*> cat_{nullptr};
+    std::atomic<std::uint64_t> id_{0};
+    std::atomic<std::int64_t> ts_{0};
+    std::atomic<std::int64_t> dur_{0};
+    std::atomic<char> phase_{0};
+    std::atomic<signed char> ready_{0};
+
+  public:
+    void write(std::uint64_t n, const trace_event& event) noexcept {
+        seq_.store(2 * n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        name_.store(event.name, std::memory_order_relaxed);
+        cat_.store(event.cat, std::memory_order_relaxed);
+        id_.store(event.id, std::memory_order_relaxed);
+        ts_.store(event.ts, std::memory_order_relaxed);
+        dur_.store(event.dur, std::memory_order_relaxed);
+        phase_.store(event.phase, std::memory_order_relaxed);
+        ready_.store(event.ready, std::memory_order_relaxed);
+        seq_.store(2 * n + 2, std::memory_order_release);
+    }
+
+    // Copies event `n` into `out`. Returns false if the slot no longer holds
+    // it, or was overwritten while being read.
+    bool read(std::uint64_t n, trace_event& out) const noexcept {
+        auto seq = seq_.load(std::memory_order_acquire);
+        if (seq != 2 * n + 2) {
+            return false;
+        }
+        out.name = name_.load(std::memory_order_relaxed);
+        out.cat = cat_.load(std::memory_order_relaxed);
+        out.id = id_.load(std::memory_order_relaxed);
+        out.ts = ts_.load(std::memory_order_relaxed);
+        out.dur = dur_.load(std::memory_order_relaxed);
+        out.phase = phase_.load(std::memory_order_relaxed);
+        out.ready = ready_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return seq_.load(std::memory_order_relaxed) == seq;
+    }
+};
+
+// Ring of events written only by its owning thread and drained by
+// `flush_trace`. When full, the oldest events are overwritten: the writer
+// never blocks or allocates.
+class trace_buffer {
+    std::unique_ptr<trace_slot[]> slots_;
+    std::size_t capacity_;
+    std::atomic<std::uint64_t> head_{0};
+    std::uint64_t tail_ = 0;  // Guarded by the buffer list mutex
+
+  public:
+    const unsigned tid;
+
+    trace_buffer(std::size_t capacity, unsigned tid)
+        : slots_(std::make_unique<trace_slot[]>(capacity)), capacity_(capacity), tid(tid) {}
+
+    void push(const trace_event& event) noexcept {
+        auto head = head_.load(std::memory_order_relaxed);
+        slots_[head % capacity_].write(head, event);
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    // Appends the events written since the last drain to `out`. May run
+    // concurrently with `push`: entries the writer overwrites before they
+    // could be copied are dropped.
+    void drain(std::vector<trace_event>& out) {
+        auto head = head_.load(std::memory_order_acquire);
+        auto begin = std::max(tail_, head > capacity_ ? head - capacity_ : 0);
+        for (auto i = begin; i < head; ++i) {
+            trace_event event;
+            if (slots_[i % capacity_].read(i, event)) {
+                out.push_back(event);
+            }
+        }
+        tail_ = head;
+    }
+};
+
+struct trace_state {
+    std::atomic<bool> active{false};
+    std::atomic<std::size_t> capacity{1 << 16};
+    std::atomic<std::uint64_t> next_id{1};
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    std::mutex mtx;
+    // Buffers of exited threads stay listed until drained
+    std::vector<std::shared_ptr<trace_buffer>> buffers;
+    unsigned next_tid = 1;
+};
+
+inline trace_state& global_trace_state() {
+    static trace_state state;
+    return state;
+}
+
+inline bool trace_active() noexcept {
+    if constexpr (tracing_enabled) {
+        return global_trace_state().active.load(std::memory_order_relaxed);
+    } else {
+        return false;
+    }
+}
+
+inline std::int64_t trace_now() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - global_trace_state().epoch
+    )
+        .count();
+}
+
+inline trace_buffer& thread_trace_buffer() {
+    thread_local std::shared_ptr<trace_buffer> buffer = [] {
+        auto& state = global_trace_state();
+        std::lock_guard lock(state.mtx);
+        auto created = std::make_shared<trace_buffer>(
+            state.capacity.load(std::memory_order_relaxed), state.next_tid++
+        );
+        state.buffers.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+inline void trace_record(const trace_event& event) noexcept {
+    thread_trace_buffer().push(event);
+}
+
+// Start time of a traced region, or -1 if tracing was off when it began, in
+// which case the region is not recorded.
+inline std::int64_t trace_begin() noexcept {
+    if constexpr (tracing_enabled) {
+        if (trace_active()) {
+            return trace_now();
+        }
+    }
+    return -1;
+}
+
+// Records the region started at `started` as a complete event
+inline void trace_complete(
+    const char* name, const char* cat, std::uint64_t id, std::int64_t started, int ready = -1
+) noexcept {
+    if constexpr (tracing_enabled) {
+        if (started >= 0) {
+            auto duration = trace_now() - started;
+            trace_record({name, cat, id, started, duration, 'X', static_cast<signed char>(ready)});
+        }
+    }
+}
+
+// A wake that resumes the poll which later calls `trace_flow_end` with the
+// same id. Recorded as a flow arrow between the two in the trace viewer.
+inline void trace_flow_begin(const void* id, std::int64_t at) noexcept {
+    if constexpr (tracing_enabled) {
+        if (at >= 0) {
+            trace_record(
+                {"wake", "pollcoro", reinterpret_cast<std::uintptr_t>(id), at, 0, 's', -1}
+            );
+        }
+    }
+}
+
+inline void trace_flow_end(const void* id, std::int64_t at) noexcept {
+    if constexpr (tracing_enabled) {
+        if (at >= 0) {
+            trace_record(
+                {"wake", "pollcoro", reinterpret_cast<std::uintptr_t>(id), at, 0, 'f', -1}
+            );
+        }
+    }
+}
+
+template<bool Enabled = tracing_enabled>
+class basic_trace_span {
+  public:
+    void begin(const char*, const char*) noexcept {}
+    void end() noexcept {}
+    std::uint64_t id() const noexcept {
+        return 0;
+    }
+    const char* name(const char* fallback) const noexcept {
+        return fallback;
+    }
+};
+
+// An async span, such as a frame's lifetime or a lock wait, that can begin
+// and end on different threads and outlive a poll. Shown as its own track in
+// the trace viewer. Move-only; moving transfers an open span.
+template<>
+class basic_trace_span<true> {
+    std::uint64_t id_ = 0;  // 0 while not open
+    const char* name_ = nullptr;
+    const char* cat_ = nullptr;
+
+  public:
+    basic_trace_span() = default;
+
+    basic_trace_span(basic_trace_span&& other) noexcept
+        : id_(std::exchange(other.id_, 0)), name_(other.name_), cat_(other.cat_) {}
+
+    basic_trace_span& operator=(basic_trace_span&& other) noexcept {
+        if (this != &other) {
+            end();
+            id_ = std::exchange(other.id_, 0);
+            name_ = other.name_;
+            cat_ = other.cat_;
+        }
+        return *this;
+    }
+
+    ~basic_trace_span() {
+        end();
+    }
+
+    void begin(const char* name, const char* cat) noexcept {
+        if (id_ == 0 && trace_active()) {
+            id_ = global_trace_state().next_id.fetch_add(1, std::memory_order_relaxed);
+            name_ = name;
+            cat_ = cat;
+            trace_record({name_, cat_, id_, trace_now(), 0, 'b', -1});
+        }
+    }
+
+    // Spans begun before tracing was started are never recorded
+    void end() noexcept {
+        if (id_ != 0) {
+            if (trace_active()) {
+                trace_record({name_, cat_, id_, trace_now(), 0, 'e', -1});
+            }
+            id_ = 0;
+        }
+    }
+
+    std::uint64_t id() const noexcept {
+        return id_;
+    }
+
+    const char* name(const char* fallback) const noexcept {
+        return id_ != 0 ? name_ : fallback;
+    }
+};
+
+using trace_span = basic_trace_span<>;
+
+inline void write_trace_string(std::FILE* out, const char* str) {
+    std::fputc('"', out);
+    for (; *str; ++str) {
+        auto c = static_cast<unsigned char>(*str);
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', out);
+            std::fputc(c, out);
+        } else if (c < 0x20) {
+            std::fprintf(out, "\\u%04x", c);
+        } else {
+            std::fputc(c, out);
+        }
+    }
+    std::fputc('"', out);
+}
+
+}  // namespace detail
+
+/// Starts recording trace events into a ring of `events_per_thread` events per
+/// thread; once a ring is full, its oldest events are overwritten. Recording
+/// only allocates when a thread records its first event, and never blocks.
+/// The capacity applies to threads that have not recorded yet.
+inline void start_tracing(std::size_t events_per_thread = 1 << 16) {
+    if constexpr (tracing_enabled) {
+        auto& state = detail::global_trace_state();
+        events_per_thread = std::max<std::size_t>(events_per_thread, 1);
+        state.capacity.store(events_per_thread, std::memory_order_relaxed);
+        state.active.store(true, std::memory_order_relaxed);
+    }
+}
+
+/// Stops recording. Recorded events are kept until `flush_trace`.
+inline void stop_tracing() noexcept {
+    if constexpr (tracing_enabled) {
+        detail::global_trace_state().active.store(false, std::memory_order_relaxed);
+    }
+}
+
+/// Writes the events recorded since the last flush to `out` as a Chrome trace
+/// JSON document, and discards them. The file can be loaded in
+/// ui.perfetto.dev or chrome://tracing.
+///
+/// Each thread is a track showing the polls of tasks, streams and `block_on`,
+/// named after the coroutine polled. Coroutine frames, mutex waits and sleeps
+/// are async tracks spanning their lifetime, and wakes of `block_on` are
+/// arrows from the waking thread to the poll they caused.
+///
+/// Safe to call while other threads record, for example periodically from a
+/// background thread; each call writes a separate, complete document.
+///
+/// Example:
+/// ```cpp
+/// pollcoro::start_tracing();
+/// pollcoro::block_on(serve());
+/// if (auto file = std::fopen("pollcoro.json", "w")) {
+///     pollcoro::flush_trace(file);
+///     std::fclose(file);
+/// }
+/// ```
+inline void flush_trace(std::FILE* out) {
+    struct thread_events {
+        unsigned tid;
+        std::vector<detail::trace_event> events;
+    };
+    std::vector<thread_events> threads;
+    if constexpr (tracing_enabled) {
+        auto& state = detail::global_trace_state();
+        std::lock_guard lock(state.mtx);
+        for (auto& buffer : state.buffers) {
+            threads.push_back({buffer->tid, {}});
+            buffer->drain(threads.back().events);
+        }
+        std::erase_if(state.buffers, [](const std::shared_ptr<detail::trace_buffer>& buffer) {
+            return buffer.use_count() == 1;
+        });
+    }
+
+    std::fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    const char* separator = "\n";
+    for (auto& thread : threads) {
+        std::fprintf(
+            out,
+            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+            "\"args\":{\"name\":\"pollcoro thread %u\"}}",
+            separator,
+            thread.tid,
+            thread.tid
+        );
+        separator = ",\n";
+        for (auto& event : thread.events) {
+            std::fprintf(out, "%s{\"name\":", separator);
+            detail::write_trace_string(out, event.name);
+            std::fprintf(out, ",\"cat\":");
+            detail::write_trace_string(out, event.cat);
+            std::fprintf(
+                out,
+                ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+                event.phase,
+                static_cast<double>(event.ts) / 1000,
+                thread.tid
+            );
+            switch (event.phase) {
+                case 'X':
+                    std::fprintf(out, ",\"dur\":%.3f", static_cast<double>(event.dur) / 1000);
+                    if (event.ready >= 0) {
+                        auto ready = event.ready ? "true" : "false";
+                        std::fprintf(out, ",\"args\":{\"ready\":%s", ready);
+                        if (event.id != 0) {
+                            std::fprintf(
+                                out, ",\"frame\":%llu", static_cast<unsigned long long>(event.id)
+                            );
+                        }
+                        std::fputc('}', out);
+                    }
+                    break;
+                case 'f':
+                    // Bind to the poll starting at the same time
+                    std::fprintf(out, ",\"bp\":\"e\"");
+                    [[fallthrough]];
+                default:
+                    std::fprintf(
+                        out, ",\"id\":\"0x%llx\"", static_cast<unsigned long long>(event.id)
+                    );
+                    break;
+            }
+            std::fputc('}', out);
+        }
+    }
+    std::fprintf(out, "\n]}\n");
+    std::fflush(out);
+}
+
+}  // namespace pollcoro
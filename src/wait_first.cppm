@@ -3,9 +3,11 @@ module;
 #if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
 #include <cstddef>
 #include <iterator>
+#include <optional>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <variant>
 #endif
 
 export module pollcoro:wait_first;
@@ -15,44 +17,104 @@ import std;
 #endif
 
 import :awaitable;
+import :cancellation;
 import :is_blocking;
 import :waker;
 
 export namespace pollcoro {
+namespace detail {
+
+// `void` results are reported as `std::monostate`
+template<typename T>
+using wait_first_value_t = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+template<awaitable... Awaitables>
+inline constexpr bool wait_first_same_result_v =
+    (std::is_same_v<
+         awaitable_result_t<std::tuple_element_t<0, std::tuple<Awaitables...>>>,
+         awaitable_result_t<Awaitables>> &&
+     ...);
+
+template<awaitable... Awaitables>
+using wait_first_result_t = std::conditional_t<
+    wait_first_same_result_v<Awaitables...>,
+    std::tuple<
+        wait_first_value_t<awaitable_result_t<std::tuple_element_t<0, std::tuple<Awaitables...>>>>,
+        std::size_t>,
+    std::variant<wait_first_value_t<awaitable_result_t<Awaitables>>...>>;
+
+}  // namespace detail
+
+/// Awaitable returned by `wait_first`. Polls every branch until one completes.
+///
+/// As soon as a winner is chosen, the losing branches are destroyed, releasing
+/// any lock waits, timers or other registrations they hold, and the ambient
+/// cancellation token they were polled with is cancelled. If every branch
+/// has the same result type, the result is a tuple of the winner's result and
+/// its index. Otherwise it is a `std::variant` holding the winner's result at
+/// the winner's index.
 template<awaitable... Awaitables>
 class wait_first_awaitable : public awaitable_maybe_blocks<Awaitables...> {
     static_assert(sizeof...(Awaitables) > 0, "wait_first requires at least one awaitable");
 
-    // All awaitables must have the same result type for wait_first
-    using first_result_t = awaitable_result_t<std::tuple_element_t<0, std::tuple<Awaitables...>>>;
-
   public:
-    using result_type = std::tuple<first_result_t, std::size_t>;
+    using result_type = detail::wait_first_result_t<Awaitables...>;
 
     explicit wait_first_awaitable(Awaitables&&... awaitables)
-        : awaitables_(std::move(awaitables)...) {}
+        : awaitables_(std::optional<Awaitables>(std::in_place, std::move(awaitables))...) {}
 
     awaitable_state<result_type> poll(const waker& w) {
-        return get_first_ready_result(std::index_sequence_for<Awaitables...>{}, w);
+        detail::cancellation_scope scope(cancellation_);
+        auto result = get_first_ready_result(std::index_sequence_for<Awaitables...>{}, w);
+        if (result.is_ready()) {
+            // Tell the losing branches to stop, then drop them
+            cancellation_.request();
+            std::apply(
+                [](auto&... awaitables) {
+                    (awaitables.reset(), ...);
+                },
+                awaitables_
+            );
+        }
+        return result;
     }
 
   private:
     template<std::size_t I>
-    auto try_get_result(const waker& w) {
-        return std::get<I>(awaitables_).poll(w).map([](auto result) {
-            return std::make_tuple(std::move(result), I);
-        });
+    bool try_get_result(const waker& w, awaitable_state<result_type>& result) {
+        auto state = std::get<I>(awaitables_)->poll(w);
+        if (!state.is_ready()) {
+            return false;
+        }
+
+        using value_type = awaitable_result_t<std::tuple_element_t<I, std::tuple<Awaitables...>>>;
+        if constexpr (detail::wait_first_same_result_v<Awaitables...>) {
+            if constexpr (std::is_void_v<value_type>) {
+                result = awaitable_state<result_type>::ready(result_type(std::monostate{}, I));
+            } else {
+                result = awaitable_state<result_type>::ready(result_type(state.take_result(), I));
+            }
+        } else {
+            if constexpr (std::is_void_v<value_type>) {
+                result = awaitable_state<result_type>::ready(result_type(std::in_place_index<I>));
+            } else {
+                result = awaitable_state<result_type>::ready(
+                    result_type(std::in_place_index<I>, state.take_result())
+                );
+            }
+        }
+        return true;
     }
 
     template<std::size_t... Is>
     auto get_first_ready_result(std::index_sequence<Is...>, const waker& w) {
-        awaitable_state<result_type> result = awaitable_state<result_type>::pending();
-        ((result = try_get_result<Is>(w), result.is_ready()) || ...);
-        return std::move(result);
+        auto result = awaitable_state<result_type>::pending();
+        (try_get_result<Is>(w, result) || ...);
+        return result;
     }
 
-    std::tuple<Awaitables...> awaitables_;
-    bool completed_{false};
+    detail::cancellation_link cancellation_;
+    std::tuple<std::optional<Awaitables>...> awaitables_;
 };
 
 template<typename VecType>
@@ -63,18 +125,22 @@ class wait_first_iter_awaitable
     using result_t = awaitable_result_t<Awaitable>;
 
   public:
-    using result_type = std::tuple<result_t, std::size_t>;
+    using result_type = std::tuple<detail::wait_first_value_t<result_t>, std::size_t>;
 
     explicit wait_first_iter_awaitable(VecType& awaitables) : awaitables_(awaitables) {}
 
     awaitable_state<result_type> poll(const waker& w) {
+        detail::cancellation_scope scope(cancellation_);
         std::size_t i = 0;
         for (auto& awaitable : awaitables_) {
             auto state = awaitable.poll(w);
             if (state.is_ready()) {
+                // Tell the losing branches to stop
+                cancellation_.request();
                 if constexpr (std::is_void_v<result_t>) {
-                    state.get_result();
-                    return awaitable_state<result_type>::ready(std::make_tuple(result_t{}, i));
+                    return awaitable_state<result_type>::ready(
+                        std::make_tuple(std::monostate{}, i)
+                    );
                 } else {
                     return awaitable_state<result_type>::ready(
                         std::make_tuple(state.take_result(), i)
@@ -87,6 +153,7 @@ class wait_first_iter_awaitable
     }
 
   private:
+    detail::cancellation_link cancellation_;
     VecType& awaitables_;
 };
 
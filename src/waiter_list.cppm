@@ -0,0 +1,165 @@
+module;
+
+#if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <array>
+#include <cstddef>
+#endif
+
+export module pollcoro:waiter_list;
+
+#if defined(POLLCORO_IMPORT_STD) && POLLCORO_IMPORT_STD == 1
+import std;
+#endif
+
+import :waker;
+
+export namespace pollcoro::detail {
+
+/// Alignment used to keep independently updated atomics on separate cache
+/// lines and avoid false sharing.
+inline constexpr std::size_t cache_line_size = 64;
+
+/// Link node embedded directly in an awaitable that waits on a synchronization
+/// primitive. All fields are owned by the primitive and must only be touched
+/// while holding its internal lock.
+struct waiter_node {
+    waiter_node* prev_ = nullptr;
+    waiter_node* next_ = nullptr;
+    waker waker_;
+    bool linked_ = false;
+};
+
+/// Intrusive FIFO of `waiter_node`s. Never allocates; insertion, removal and
+/// relinking of a node are all O(1).
+class waiter_list {
+    waiter_node* head_ = nullptr;
+    waiter_node* tail_ = nullptr;
+    std::size_t size_ = 0;
+
+  public:
+    waiter_list() = default;
+
+    waiter_list(const waiter_list&) = delete;
+    waiter_list& operator=(const waiter_list&) = delete;
+
+    bool empty() const noexcept {
+        return head_ == nullptr;
+    }
+
+    std::size_t size() const noexcept {
+        return size_;
+    }
+
+    waiter_node* front() const noexcept {
+        return head_;
+    }
+
+    void push_back(waiter_node* node) noexcept {
+        node->prev_ = tail_;
+        node->next_ = nullptr;
+        if (tail_) {
+            tail_->next_ = node;
+        } else {
+            head_ = node;
+        }
+        tail_ = node;
+        node->linked_ = true;
+        ++size_;
+    }
+
+    void push_front(waiter_node* node) noexcept {
+        node->prev_ = nullptr;
+        node->next_ = head_;
+        if (head_) {
+            head_->prev_ = node;
+        } else {
+            tail_ = node;
+        }
+        head_ = node;
+        node->linked_ = true;
+        ++size_;
+    }
+
+    void remove(waiter_node* node) noexcept {
+        if (node->prev_) {
+            node->prev_->next_ = node->next_;
+        } else {
+            head_ = node->next_;
+        }
+        if (node->next_) {
+            node->next_->prev_ = node->prev_;
+        } else {
+            tail_ = node->prev_;
+        }
+        node->prev_ = nullptr;
+        node->next_ = nullptr;
+        node->linked_ = false;
+        --size_;
+    }
+
+    waiter_node* pop_front() noexcept {
+        auto node = head_;
+        if (node) {
+            remove(node);
+        }
+        return node;
+    }
+
+    /// Moves the position held by `from` in the list over to `to`. Used when an
+    /// awaitable that is already registered gets move-constructed.
+    void replace(waiter_node* from, waiter_node* to) noexcept {
+        to->prev_ = from->prev_;
+        to->next_ = from->next_;
+        to->linked_ = true;
+        if (to->prev_) {
+            to->prev_->next_ = to;
+        } else {
+            head_ = to;
+        }
+        if (to->next_) {
+            to->next_->prev_ = to;
+        } else {
+            tail_ = to;
+        }
+        from->prev_ = nullptr;
+        from->next_ = nullptr;
+        from->linked_ = false;
+    }
+};
+
+/// Wakers collected while a primitive's internal lock is held, to be invoked
+/// once it has been released. Calling arbitrary wakers under the lock would
+/// serialize the wakeups behind it and deadlock with executors that poll the
+/// woken task inline. Holds up to `N` wakers on the stack.
+///
+/// Wakers are copied out of the nodes, which their waiters may free as soon as
+/// they observe the handoff. A waker may therefore run after its awaitable has
+/// completed; see `waker` for what that requires of executors.
+template<std::size_t N = 8>
+class wake_batch {
+    std::array<waker, N> wakers_;
+    std::size_t size_ = 0;
+
+  public:
+    wake_batch() = default;
+
+    wake_batch(const wake_batch&) = delete;
+    wake_batch& operator=(const wake_batch&) = delete;
+
+    bool full() const noexcept {
+        return size_ == N;
+    }
+
+    void push(const waker& w) noexcept {
+        wakers_[size_++] = w;
+    }
+
+    void wake_all() noexcept {
+        for (std::size_t i = 0; i < size_; ++i) {
+            wakers_[i].wake();
+        }
+        size_ = 0;
+    }
+};
+
+}  // namespace pollcoro::detail
@@ -1,7 +1,18 @@
 module;
 
+#if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <mutex>
+#include <vector>
+#endif
+
 export module pollcoro:waker;
 
+#if defined(POLLCORO_IMPORT_STD) && POLLCORO_IMPORT_STD == 1
+import std;
+#endif
+
+import :instrument;
+
 export namespace pollcoro {
 class waker;  // Forward declaration
 
@@ -14,6 +25,13 @@ inline void waker_wake_function(void* data) noexcept {
 
 }  // namespace detail
 
+/// Handle an awaitable calls to have its task polled again. A waker does not
+/// own its target, which belongs to the executor.
+///
+/// A waker may be invoked after the awaitable it was given to has completed
+/// or been dropped: synchronization primitives hand a waiter its result and
+/// only then wake it, outside their internal lock. Executors must keep the
+/// target valid past that point and treat such a late wake as spurious.
 class waker {
     void (*wake_function_)(void*) = nullptr;
     void* data_ = nullptr;
@@ -33,6 +51,7 @@ class waker {
           data_(static_cast<void*>(waker_ptr)) {}
 
     void wake() const noexcept {
+        detail::instrument_wake(data_);
         if (wake_function_) {
             wake_function_(data_);
         }
@@ -42,4 +61,88 @@ class waker {
         return data_ == other.data_ && wake_function_ == other.wake_function_;
     }
 };
+
+namespace detail {
+
+// Refreshes the waker stored by a waiter that was polled again while still
+// waiting. Skips the store when `w` would wake the same task, so that repeated
+// polls from one executor don't rewrite shared state.
+inline void rearm_waker(waker& stored, const waker& w) noexcept {
+    bool replace = !stored.will_wake(w);
+    if (replace) {
+        stored = w;
+    }
+    instrument_rearm(replace);
+}
+
+// Owns an executor's waker target of type `T`. A late wake may still reach
+// the target after its executor has finished with it, so targets are never
+// freed: they go back to a free list, and a late wake arrives at whoever uses
+// the target next as a spurious one. `T` must be default-constructible and
+// safe to reuse.
+template<typename T>
+class recycled_waker_target {
+    struct global_free_list {
+        std::mutex mtx;
+        std::vector<T*> free;
+    };
+
+    // Hands the targets cached by an exiting thread over to the other threads
+    struct local_free_list {
+        std::vector<T*> free;
+
+        ~local_free_list() {
+            auto& global = global_free();
+            std::lock_guard lock(global.mtx);
+            global.free.insert(global.free.end(), free.begin(), free.end());
+        }
+    };
+
+    static global_free_list& global_free() {
+        // Leaked, as threads may still exit after static destruction
+        static auto* list = new global_free_list;
+        return *list;
+    }
+
+    static inline thread_local local_free_list local_free_;
+
+    static T* acquire() {
+        auto& local = local_free_.free;
+        if (!local.empty()) {
+            auto target = local.back();
+            local.pop_back();
+            return target;
+        }
+        auto& global = global_free();
+        std::lock_guard lock(global.mtx);
+        if (global.free.empty()) {
+            return new T();
+        }
+        auto target = global.free.back();
+        global.free.pop_back();
+        return target;
+    }
+
+    T* target_ = acquire();
+
+  public:
+    recycled_waker_target() = default;
+
+    recycled_waker_target(const recycled_waker_target&) = delete;
+    recycled_waker_target& operator=(const recycled_waker_target&) = delete;
+
+    ~recycled_waker_target() {
+        local_free_.free.push_back(target_);
+    }
+
+    T& operator*() const noexcept {
+        return *target_;
+    }
+
+    T* operator->() const noexcept {
+        return target_;
+    }
+};
+
+}  // namespace detail
 }  // namespace pollcoro
@@ -0,0 +1,246 @@
+module;
+
+#if !defined(POLLCORO_IMPORT_STD) || POLLCORO_IMPORT_STD == 0
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#endif
+
+export module pollcoro:watch;
+
+#if defined(POLLCORO_IMPORT_STD) && POLLCORO_IMPORT_STD == 1
+import std;
+#endif
+
+import :is_blocking;
+import :stream_awaitable;
+import :waiter_list;
+import :waker;
+
+export namespace pollcoro {
+
+template<typename T>
+class watch;
+template<typename T>
+class watch_subscriber;
+
+namespace detail {
+
+template<typename T>
+struct watch_state {
+    mutable std::mutex mtx_;
+    T value_;
+    std::atomic<std::uint64_t> version_{0};
+    bool closed_{false};
+    waiter_list waiters_;
+
+    explicit watch_state(T value) : value_(std::move(value)) {}
+
+    // Must be called with `mtx_` held through `lock`, which it releases.
+    // Every subscriber present is unlinked and woken; they re-register on
+    // their next poll. One that re-registers while the batch is being flushed
+    // may be woken as well, which is harmless since it re-checks the version.
+    void wake_all(std::unique_lock<std::mutex>& lock) {
+        wake_batch batch;
+        for (auto n = waiters_.size(); n > 0 && !waiters_.empty(); --n) {
+            if (batch.full()) {
+                lock.unlock();
+                batch.wake_all();
+                lock.lock();
+            }
+            batch.push(waiters_.pop_front()->waker_);
+        }
+        lock.unlock();
+        batch.wake_all();
+    }
+};
+
+}  // namespace detail
+
+/// Subscription to a `watch`. A subscriber is a stream that yields a copy of
+/// the latest value each time the watch's version advances past the last one it
+/// observed. Updates that happen while the subscriber is not being polled are
+/// coalesced, so a slow subscriber only ever sees the newest value.
+///
+/// The stream finishes once `watch::close()` has been called. The watch must
+/// outlive all of its subscribers.
+template<typename T>
+class watch_subscriber : public awaitable_always_blocks {
+    detail::watch_state<T>* state_;
+    std::uint64_t seen_;
+    detail::waiter_node node_;
+
+    using state_type = stream_awaitable_state<T>;
+
+    void deregister() {
+        if (state_) {
+            std::lock_guard lock(state_->mtx_);
+            if (node_.linked_) {
+                state_->waiters_.remove(&node_);
+            }
+        }
+    }
+
+    friend class watch<T>;
+
+    watch_subscriber(detail::watch_state<T>* state, std::uint64_t seen)
+        : state_(state), seen_(seen) {}
+
+  public:
+    watch_subscriber(const watch_subscriber& other)
+        : state_(other.state_), seen_(other.seen_) {}
+
+    watch_subscriber& operator=(const watch_subscriber& other) {
+        if (this != &other) {
+            deregister();
+            state_ = other.state_;
+            seen_ = other.seen_;
+        }
+        return *this;
+    }
+
+    watch_subscriber(watch_subscriber&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)), seen_(other.seen_) {
+        if (state_) {
+            std::lock_guard lock(state_->mtx_);
+            if (other.node_.linked_) {
+                state_->waiters_.replace(&other.node_, &node_);
+                node_.waker_ = other.node_.waker_;
+            }
+        }
+    }
+
+    watch_subscriber& operator=(watch_subscriber&& other) noexcept {
+        if (this != &other) {
+            deregister();
+            state_ = std::exchange(other.state_, nullptr);
+            seen_ = other.seen_;
+            if (state_) {
+                std::lock_guard lock(state_->mtx_);
+                if (other.node_.linked_) {
+                    state_->waiters_.replace(&other.node_, &node_);
+                    node_.waker_ = other.node_.waker_;
+                }
+            }
+        }
+        return *this;
+    }
+
+    ~watch_subscriber() {
+        deregister();
+    }
+
+    state_type poll_next(const waker& w) {
+        std::lock_guard lock(state_->mtx_);
+        auto version = state_->version_.load(std::memory_order_relaxed);
+        if (version != seen_) {
+            seen_ = version;
+            if (node_.linked_) {
+                state_->waiters_.remove(&node_);
+            }
+            return state_type::ready(state_->value_);
+        }
+        if (state_->closed_) {
+            if (node_.linked_) {
+                state_->waiters_.remove(&node_);
+            }
+            return state_type::done();
+        }
+        if (node_.linked_) {
+            detail::rearm_waker(node_.waker_, w);
+        } else {
+            node_.waker_ = w;
+            state_->waiters_.push_back(&node_);
+        }
+        return state_type::pending();
+    }
+
+    /// Returns true if the watch has been updated since this subscriber last
+    /// yielded a value. Does not take the internal lock.
+    bool has_changed() const {
+        return state_->version_.load(std::memory_order_acquire) != seen_;
+    }
+
+    /// Returns a copy of the current value without marking it as seen.
+    T get() const {
+        std::lock_guard lock(state_->mtx_);
+        return state_->value_;
+    }
+};
+
+/// A single-producer, multi-subscriber cell holding the latest value of
+/// something, such as a configuration snapshot.
+///
+/// Every `set()` bumps a version number and wakes all subscribers; there is no
+/// per-subscriber queue, so fan-out never allocates and a subscriber that falls
+/// behind simply observes the most recent value.
+///
+/// Example:
+/// ```cpp
+/// pollcoro::watch<config> current_config{load_config()};
+///
+/// task<void> worker() {
+///     auto updates = current_config.subscribe();
+///     while (auto cfg = co_await pollcoro::next(updates)) {
+///         apply(*cfg);
+///     }
+/// }
+///
+/// void reload() {
+///     current_config.set(load_config());
+/// }
+/// ```
+template<typename T>
+class watch {
+    detail::watch_state<T> state_;
+
+  public:
+    explicit watch(T initial = T()) : state_(std::move(initial)) {}
+
+    watch(const watch&) = delete;
+    watch& operator=(const watch&) = delete;
+
+    /// Replaces the value and wakes every subscriber.
+    void set(T value) {
+        std::unique_lock lock(state_.mtx_);
+        state_.value_ = std::move(value);
+        state_.version_.fetch_add(1, std::memory_order_release);
+        state_.wake_all(lock);
+    }
+
+    /// Updates the value in place and wakes every subscriber.
+    template<typename Func>
+    void modify(Func&& func) {
+        std::unique_lock lock(state_.mtx_);
+        std::invoke(std::forward<Func>(func), state_.value_);
+        state_.version_.fetch_add(1, std::memory_order_release);
+        state_.wake_all(lock);
+    }
+
+    /// Returns a copy of the current value.
+    T get() const {
+        std::lock_guard lock(state_.mtx_);
+        return state_.value_;
+    }
+
+    /// Returns the number of updates made so far.
+    std::uint64_t version() const {
+        return state_.version_.load(std::memory_order_acquire);
+    }
+
+    /// Returns a subscriber that yields on every change made after this call.
+    watch_subscriber<T> subscribe() {
+        return watch_subscriber<T>(&state_, version());
+    }
+
+    /// Finishes every subscriber's stream once it has seen the latest value.
+    void close() {
+        std::unique_lock lock(state_.mtx_);
+        state_.closed_ = true;
+        state_.wake_all(lock);
+    }
+};
+
+}  // namespace pollcoro
@@ -15,6 +15,7 @@ import std;
 #endif
 
 import :awaitable;
+import :budget;
 import :is_blocking;
 import :stream_awaitable;
 import :waker;
@@ -53,6 +54,9 @@ class window_stream_awaitable : public awaitable_maybe_blocks<StreamAwaitable> {
                     return state_type::ready(std::move(result));
                 }
 
+                if (!consume_budget(w)) {
+                    return state_type::pending();
+                }
                 continue;
             }
 
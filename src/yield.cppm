@@ -24,11 +24,12 @@ class yield_awaitable : public awaitable_always_blocks {
     explicit yield_awaitable(std::size_t ready) : ready_(ready) {}
 
     awaitable_state<> poll(const waker& w) {
-        if (ready_ > 0) {
-            ready_--;
+        if (ready_ == 0) {
+            return awaitable_state<>::ready();
         }
+        ready_--;
         w.wake();
-        return ready_ == 0 ? awaitable_state<>::ready() : awaitable_state<>::pending();
+        return awaitable_state<>::pending();
     }
 };
 